@@ -0,0 +1,22 @@
+# - Find ZSTD
+# Find the native zstd includes and library
+#
+#  ZSTD_INCLUDES    - where to find zstd.h
+#  ZSTD_LIBRARIES   - List of libraries when using zstd.
+#  ZSTD_FOUND       - True if zstd found.
+
+if (ZSTD_INCLUDES)
+  # Already in cache, be silent
+  set (ZSTD_FIND_QUIETLY TRUE)
+endif (ZSTD_INCLUDES)
+
+find_path (ZSTD_INCLUDES zstd.h)
+
+find_library (ZSTD_LIBRARIES NAMES zstd)
+
+# handle the QUIETLY and REQUIRED arguments and set ZSTD_FOUND to TRUE if
+# all listed variables are TRUE
+include (FindPackageHandleStandardArgs)
+find_package_handle_standard_args (ZSTD DEFAULT_MSG ZSTD_LIBRARIES ZSTD_INCLUDES)
+
+#mark_as_advanced (ZSTD_LIBRARIES ZSTD_INCLUDES)
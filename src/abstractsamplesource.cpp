@@ -24,10 +24,10 @@ void AbstractSampleSource::subscribe(Subscriber *subscriber)
     subscribers.insert(subscriber);
 }
 
-void AbstractSampleSource::invalidate()
+void AbstractSampleSource::invalidate(const Invalidation &invalidation)
 {
     for (auto subscriber : subscribers) {
-        subscriber->invalidateEvent();
+        subscriber->invalidateEvent(invalidation);
     }
 }
 
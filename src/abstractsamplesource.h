@@ -36,7 +36,7 @@ public:
     void unsubscribe(Subscriber *subscriber);
 
 protected:
-    virtual void invalidate();
+    virtual void invalidate(const Invalidation &invalidation = Invalidation::parameters());
 
 private:
     std::set<Subscriber*> subscribers;
@@ -0,0 +1,399 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QImage>
+#include <QPainter>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "amplitudedemod.h"
+#include "frequencydemod.h"
+#include "kernels.h"
+#include "phasedemod.h"
+#include "sampleadapter.h"
+#include "spectrogramengine.h"
+#include "spectrogramplot.h"
+#include "threshold.h"
+#include "traceplot.h"
+#include "tunertransform.h"
+
+/*
+ * Throughput of the per-sample hot paths, on synthetic IQ generated in
+ * process so runs are repeatable on any machine. Each benchmark is called
+ * repeatedly until it has run for at least --min-time seconds, and the
+ * rate is reported in samples per second and nanoseconds per sample.
+ */
+
+static const double sampleRate = 1e6;
+
+// Two tones in a little noise, repeated forever, so spectrogram tiles can
+// be fetched at ever-increasing positions without hitting the tile caches
+class SyntheticSource : public SampleSource<std::complex<float>>
+{
+public:
+    SyntheticSource(size_t length) : samples(length) {
+        std::mt19937 rng(1);
+        std::normal_distribution<float> noise(0.0f, 0.05f);
+        for (size_t i = 0; i < length; i++) {
+            samples[i] = 0.5f * std::polar(1.0f, (float)(Tau * fmod(0.1 * i, 1.0)))
+                       + 0.25f * std::polar(1.0f, (float)(Tau * fmod(-0.27 * i, 1.0)))
+                       + std::complex<float>(noise(rng), noise(rng));
+        }
+    }
+
+    std::unique_ptr<std::complex<float>[]> getSamples(size_t start, size_t length) override {
+        auto dest = std::make_unique<std::complex<float>[]>(length);
+        for (size_t i = 0; i < length;) {
+            size_t offset = (start + i) % samples.size();
+            size_t n = std::min(length - i, samples.size() - offset);
+            std::copy(&samples[offset], &samples[offset + n], &dest[i]);
+            i += n;
+        }
+        return dest;
+    }
+    size_t count() override { return (size_t)1 << 40; };
+    double rate() override { return sampleRate; };
+    float relativeBandwidth() override { return 1; };
+
+    std::vector<std::complex<float>> samples;
+};
+
+class Benchmarks
+{
+public:
+    Benchmarks(const QString &filter, double minTime) : filter(filter), minTime(minTime) { };
+
+    // Time fn, which processes samples samples per call
+    void run(const QString &name, size_t samples, const std::function<void()> &fn)
+    {
+        if (!name.contains(filter))
+            return;
+
+        using clock = std::chrono::steady_clock;
+        fn();
+        size_t iterations = 1;
+        double elapsed;
+        while (true) {
+            auto start = clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                fn();
+            }
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            if (elapsed >= minTime)
+                break;
+            iterations *= 2;
+        }
+
+        double total = (double)samples * iterations;
+        printf("%-48s %14.1f %10.3f\n", name.toUtf8().constData(),
+               total / elapsed, elapsed * 1e9 / total);
+        fflush(stdout);
+    }
+
+private:
+    QString filter;
+    double minTime;
+};
+
+// Store samples as T, the way a file of that format would hold them
+template<typename T>
+static std::vector<char> encode(const std::vector<std::complex<float>> &samples, bool complex, float scale, float offset)
+{
+    const int channels = complex ? 2 : 1;
+    std::vector<char> raw(samples.size() * channels * sizeof(T));
+    auto out = reinterpret_cast<T*>(raw.data());
+    auto convert = [&](float v) {
+        double x = (double)v * scale + offset;
+        if (std::numeric_limits<T>::is_integer)
+            x = std::min(std::max(x, (double)std::numeric_limits<T>::min()), (double)std::numeric_limits<T>::max());
+        return (T)x;
+    };
+    for (auto &s : samples) {
+        *out++ = convert(s.real());
+        if (complex)
+            *out++ = convert(s.imag());
+    }
+    return raw;
+}
+
+// The same samples with the bytes of each value of size bytes reversed
+static std::vector<char> bigEndian(std::vector<char> raw, size_t size)
+{
+    for (size_t i = 0; i + size <= raw.size(); i += size) {
+        std::reverse(&raw[i], &raw[i + size]);
+    }
+    return raw;
+}
+
+// Packed formats, where every bit pattern is a valid sample
+static std::vector<char> randomBytes(size_t length)
+{
+    std::mt19937 rng(2);
+    std::vector<char> raw(length);
+    for (auto &b : raw) {
+        b = (char)rng();
+    }
+    return raw;
+}
+
+static void benchAdapters(Benchmarks &bench, const std::vector<size_t> &sizes, const std::vector<std::complex<float>> &samples)
+{
+    struct Format {
+        const char *name;
+        std::unique_ptr<SampleAdapter> adapter;
+        std::vector<char> raw;
+    };
+    std::vector<Format> formats;
+    auto add = [&](const char *name, SampleAdapter *adapter, std::vector<char> raw) {
+        formats.push_back({name, std::unique_ptr<SampleAdapter>(adapter), std::move(raw)});
+    };
+    add("cf32", new ComplexF32SampleAdapter(), encode<float>(samples, true, 1, 0));
+    add("cf64", new ComplexF64SampleAdapter(), encode<double>(samples, true, 1, 0));
+    add("cs32", new ComplexS32SampleAdapter(), encode<int32_t>(samples, true, 2147483648.0f, 0));
+    add("cs16", new ComplexS16SampleAdapter(), encode<int16_t>(samples, true, 32768, 0));
+    add("cf32_be", new ComplexF32BESampleAdapter(), bigEndian(encode<float>(samples, true, 1, 0), 4));
+    add("cf64_be", new ComplexF64BESampleAdapter(), bigEndian(encode<double>(samples, true, 1, 0), 8));
+    add("cs32_be", new ComplexS32BESampleAdapter(), bigEndian(encode<int32_t>(samples, true, 2147483648.0f, 0), 4));
+    add("cs16_be", new ComplexS16BESampleAdapter(), bigEndian(encode<int16_t>(samples, true, 32768, 0), 2));
+    add("cs8", new ComplexS8SampleAdapter(), encode<int8_t>(samples, true, 128, 0));
+    add("cs12", new ComplexS12SampleAdapter(), randomBytes(samples.size() * 3));
+    add("cs4", new ComplexS4SampleAdapter(), randomBytes(samples.size()));
+    add("cu8", new ComplexU8SampleAdapter(), encode<uint8_t>(samples, true, 128, 127.4f));
+    add("f32", new RealF32SampleAdapter(), encode<float>(samples, false, 1, 0));
+    add("f64", new RealF64SampleAdapter(), encode<double>(samples, false, 1, 0));
+    add("s16", new RealS16SampleAdapter(), encode<int16_t>(samples, false, 32768, 0));
+    add("s8", new RealS8SampleAdapter(), encode<int8_t>(samples, false, 128, 0));
+    add("u8", new RealU8SampleAdapter(), encode<uint8_t>(samples, false, 128, 127.4f));
+    add("f32_be", new RealF32BESampleAdapter(), bigEndian(encode<float>(samples, false, 1, 0), 4));
+    add("f64_be", new RealF64BESampleAdapter(), bigEndian(encode<double>(samples, false, 1, 0), 8));
+    add("s16_be", new RealS16BESampleAdapter(), bigEndian(encode<int16_t>(samples, false, 32768, 0), 2));
+    add("s12", new RealS12SampleAdapter(), randomBytes((samples.size() + 1) / 2 * 3));
+    add("s4", new RealS4SampleAdapter(), randomBytes((samples.size() + 1) / 2));
+    add("cs16_ch1_of_2", new InterleavedSampleAdapter(std::make_shared<ComplexS16SampleAdapter>(), 2, 1), randomBytes(samples.size() * 8));
+    add("cs16_ch3_of_8", new InterleavedSampleAdapter(std::make_shared<ComplexS16SampleAdapter>(), 8, 3), randomBytes(samples.size() * 32));
+
+    std::vector<std::complex<float>> dest(samples.size());
+    for (auto &format : formats) {
+        for (auto size : sizes) {
+            bench.run(QString("copyRange/%1/%2").arg(format.name).arg(size), size, [&]() {
+                format.adapter->copyRange(format.raw.data(), 0, size, dest.data());
+            });
+        }
+    }
+}
+
+static void benchSpectrogram(Benchmarks &bench, std::shared_ptr<SyntheticSource> source)
+{
+    const int tileSize = SpectrogramEngine::tileSize;
+    std::vector<float> dest(tileSize);
+
+    for (int fftSize : {256, 2048, 16384}) {
+        SpectrogramEngine engine(source);
+        engine.setFFTSize(fftSize);
+        size_t sample = 0;
+        bench.run(QString("getLine/%1").arg(fftSize), fftSize, [&]() {
+            engine.getLine(dest.data(), sample);
+            sample += fftSize;
+        });
+        bench.run(QString("getFFTTile/%1").arg(fftSize), tileSize, [&]() {
+            engine.getFFTTile(dest.data(), sample);
+            sample += tileSize;
+        });
+    }
+
+    // Every call is for a new tile, so these include the cost of caching
+    // and, for pixmaps, colouring and converting the tile
+    for (int fftSize : {256, 2048, 16384}) {
+        SpectrogramPlot plot(source);
+        plot.setFFTSize(fftSize);
+        size_t tile = 0;
+        bench.run(QString("SpectrogramPlot::getFFTTile/%1").arg(fftSize), tileSize, [&]() {
+            plot.getFFTTile(tile);
+            tile += tileSize;
+        });
+        bench.run(QString("SpectrogramPlot::getPixmapTile/%1").arg(fftSize), tileSize, [&]() {
+            plot.getPixmapTile(tile);
+            tile += tileSize;
+        });
+    }
+}
+
+static void benchTransforms(Benchmarks &bench, const std::vector<size_t> &sizes, std::shared_ptr<SyntheticSource> source)
+{
+    auto in = source->samples.data();
+    std::vector<std::complex<float>> out(source->samples.size());
+
+    for (size_t taps : {1, 31, 127, 511}) {
+        TunerTransform tuner(source);
+        tuner.setFrequency(0.1 * Tau);
+        tuner.setTaps(std::vector<float>(taps, 1.0f / taps));
+        for (auto size : sizes) {
+            size_t sampleid = 0;
+            bench.run(QString("TunerTransform::work/%1taps/%2").arg(taps).arg(size), size, [&]() {
+                tuner.work(in, out.data(), size, sampleid);
+                sampleid += size;
+            });
+        }
+    }
+
+    std::vector<float> real(source->samples.size());
+    std::vector<float> realOut(source->samples.size());
+    auto amplitude = std::make_shared<AmplitudeDemod>(source);
+    FrequencyDemod frequency(source);
+    PhaseDemod phase(source);
+    Threshold threshold(amplitude);
+    amplitude->work(in, real.data(), real.size(), 0);
+    for (auto size : sizes) {
+        bench.run(QString("AmplitudeDemod::work/%1").arg(size), size, [&]() {
+            amplitude->work(in, realOut.data(), size, 0);
+        });
+        size_t sampleid = 0;
+        bench.run(QString("FrequencyDemod::work/%1").arg(size), size, [&]() {
+            frequency.work(in, realOut.data(), size, sampleid);
+            sampleid += size;
+        });
+        bench.run(QString("PhaseDemod::work/%1").arg(size), size, [&]() {
+            phase.work(in, realOut.data(), size, 0);
+        });
+        bench.run(QString("Threshold::work/%1").arg(size), size, [&]() {
+            threshold.work(real.data(), realOut.data(), size, 0);
+        });
+    }
+}
+
+// The vectorized kernels against their scalar references
+static void benchKernels(Benchmarks &bench, const std::vector<size_t> &sizes, std::shared_ptr<SyntheticSource> source)
+{
+    // Every kernel against its scalar reference. The synthetic samples
+    // double as the packed and big-endian input, which is never larger.
+    auto in = source->samples.data();
+    auto bytes = reinterpret_cast<const uint8_t*>(in);
+    auto values = reinterpret_cast<const float*>(in);
+    std::vector<float> out(source->samples.size());
+    std::vector<std::complex<float>> samples(source->samples.size());
+    std::vector<int16_t> quantized(source->samples.size() * 2);
+    std::vector<uint8_t> gathered(source->samples.size() * sizeof(int16_t) * 2);
+    const std::complex<float> prev = 1;
+    for (auto size : sizes) {
+        auto pair = [&](const QString &name, const std::function<void()> &fast, const std::function<void()> &scalar) {
+            bench.run(QString("kernels::%1/%2").arg(name).arg(size), size, fast);
+            bench.run(QString("kernels::%1Scalar/%2").arg(name).arg(size), size, scalar);
+        };
+        pair("phase",
+             [&]() { kernels::phase(in, out.data(), size, 1.0f); },
+             [&]() { kernels::phaseScalar(in, out.data(), size, 1.0f); });
+        pair("magnitudeSquared",
+             [&]() { kernels::magnitudeSquared(in, out.data(), size, 2.0f, -1.0f); },
+             [&]() { kernels::magnitudeSquaredScalar(in, out.data(), size, 2.0f, -1.0f); });
+        pair("powerDb",
+             [&]() { kernels::powerDb(in, out.data(), size, 1.0f); },
+             [&]() { kernels::powerDbScalar(in, out.data(), size, 1.0f); });
+        pair("fmDemod",
+             [&]() { kernels::fmDemod(in, out.data(), size, prev, 1.0f); },
+             [&]() { kernels::fmDemodScalar(in, out.data(), size, prev, 1.0f); });
+        pair("unpack12",
+             [&]() { kernels::unpack12(bytes, samples.data(), size, true); },
+             [&]() { kernels::unpack12Scalar(bytes, samples.data(), size, true); });
+        pair("unpack4",
+             [&]() { kernels::unpack4(bytes, samples.data(), size, true); },
+             [&]() { kernels::unpack4Scalar(bytes, samples.data(), size, true); });
+        pair("convertBigEndian",
+             [&]() { kernels::convertBigEndian(reinterpret_cast<const int16_t*>(in), samples.data(), size, true, 1.0f / 32768); },
+             [&]() { kernels::convertBigEndianScalar(reinterpret_cast<const int16_t*>(in), samples.data(), size, true, 1.0f / 32768); });
+        // One channel of two interleaved cs16 channels
+        pair("gather",
+             [&]() { kernels::gather(bytes, 8, 4, gathered.data(), size); },
+             [&]() { kernels::gatherScalar(bytes, 8, 4, gathered.data(), size); });
+        // I and Q of each sample, as when exporting cs16
+        pair("quantize",
+             [&]() { kernels::quantize(values, quantized.data(), size * 2, 32767.0f, 0.0f, true, 1); },
+             [&]() { kernels::quantizeScalar(values, quantized.data(), size * 2, 32767.0f, 0.0f, true, 1); });
+    }
+}
+
+static void benchTrace(Benchmarks &bench, const std::vector<size_t> &sizes, std::shared_ptr<SyntheticSource> source)
+{
+    // Same size and settings as a TracePlot tile
+    QImage image(1000, 200, QImage::Format_ARGB32);
+    auto samples = reinterpret_cast<float*>(source->samples.data());
+    for (auto size : sizes) {
+        bench.run(QString("TracePlot::plotTrace/%1").arg(size), size, [&]() {
+            image.fill(Qt::transparent);
+            QPainter painter(&image);
+            painter.setRenderHint(QPainter::Antialiasing, true);
+            painter.setPen(Qt::red);
+            TracePlot::plotTrace(painter, image.rect(), samples, size, 2);
+        });
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Spectrogram tiles are pixmaps, which need a GUI application, but not
+    // a display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+    a.setApplicationName("inspectrum_bench");
+    a.setOrganizationName("inspectrum");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure the throughput of inspectrum's sample processing");
+    parser.addHelpOption();
+
+    QCommandLineOption filterOption(QStringList() << "filter",
+                                  QCoreApplication::translate("main", "Only run benchmarks whose name contains text."),
+                                  QCoreApplication::translate("main", "text"));
+    parser.addOption(filterOption);
+    QCommandLineOption minTimeOption(QStringList() << "min-time",
+                                  QCoreApplication::translate("main", "Minimum time to run each benchmark for (default 0.2)."),
+                                  QCoreApplication::translate("main", "seconds"), "0.2");
+    parser.addOption(minTimeOption);
+
+    parser.process(a);
+
+    bool ok;
+    double minTime = parser.value(minTimeOption).toDouble(&ok);
+    if (!ok) {
+        fputs("ERROR: could not parse min-time\n", stderr);
+        return 1;
+    }
+
+    const std::vector<size_t> sizes = {4096, 65536, 1 << 20};
+    auto source = std::make_shared<SyntheticSource>(sizes.back());
+    Benchmarks bench(parser.value(filterOption), minTime);
+
+    printf("%-48s %14s %10s\n", "benchmark", "samples/s", "ns/sample");
+    benchAdapters(bench, sizes, source->samples);
+    benchSpectrogram(bench, source);
+    benchTransforms(bench, sizes, source);
+    benchKernels(bench, sizes, source);
+    benchTrace(bench, sizes, source);
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QRunnable>
+#include <algorithm>
+#include <errno.h>
+#include <functional>
+#include "bufferedfile.h"
+#include "tracing.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+class PrefetchTask : public QRunnable
+{
+public:
+    PrefetchTask(const std::function<void()> &fn) : fn(fn) { };
+    void run() override { fn(); };
+
+private:
+    std::function<void()> fn;
+};
+
+}
+
+BufferedFile::BufferedFile(QFile *file, size_t overlap, size_t blockSize, int maxBlocks)
+    : file(file), fileSize(file->size()), overlap(overlap), blockSize(blockSize), maxBlocks(maxBlocks)
+{
+    pool.setMaxThreadCount(readThreads);
+}
+
+BufferedFile::~BufferedFile()
+{
+    stopReading();
+}
+
+void BufferedFile::stopReading()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+size_t BufferedFile::size()
+{
+    QMutexLocker locker(&mutex);
+    return fileSize;
+}
+
+void BufferedFile::setSize(size_t size, int maxBlocks)
+{
+    QMutexLocker locker(&mutex);
+    fileSize = size;
+    this->maxBlocks = maxBlocks;
+}
+
+range_t<size_t> BufferedFile::blockSpan(size_t offset)
+{
+    size_t start = offset - offset % blockSize;
+    return {start, std::min(fileSize, start + blockSize)};
+}
+
+size_t BufferedFile::blockLength(range_t<size_t> span)
+{
+    return std::min(fileSize, span.maximum + overlap) - span.minimum;
+}
+
+void BufferedFile::resize(size_t size)
+{
+    QMutexLocker locker(&mutex);
+
+    fileSize = size;
+    blocks.remove_if([this](const std::shared_ptr<Buffer> &b) {
+        return b->offset >= fileSize || b->length != blockLength(blockSpan(b->offset));
+    });
+}
+
+// Called with mutex held
+std::shared_ptr<BufferedFile::Buffer> BufferedFile::cached(size_t offset)
+{
+    for (auto it = blocks.begin(); it != blocks.end(); it++) {
+        if ((*it)->offset == offset) {
+            blocks.splice(blocks.begin(), blocks, it);
+            return blocks.front();
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const FileReader::Block> BufferedFile::block(size_t offset)
+{
+    QMutexLocker locker(&mutex);
+
+    if (offset >= fileSize)
+        return nullptr;
+
+    // Wait for the block if it's already being read
+    auto span = blockSpan(offset);
+    while (true) {
+        if (auto b = cached(span.minimum))
+            return b;
+        if (reading.count(span.minimum) == 0)
+            break;
+        blockRead.wait(&mutex);
+    }
+
+    size_t length = blockLength(span);
+    reading.insert(span.minimum);
+    locker.unlock();
+
+    auto buffer = read(span.minimum, length);
+
+    locker.relock();
+    finishRead(span, buffer);
+    return buffer;
+}
+
+void BufferedFile::prefetch(size_t offset, size_t length)
+{
+    QMutexLocker locker(&mutex);
+
+    // Leave at least half the cache for the blocks in use
+    size_t end = std::min(fileSize, offset + length);
+    for (int n = 0; offset < end && n < maxBlocks / 2; n++) {
+        auto span = blockSpan(offset);
+        offset = span.maximum;
+        if (reading.count(span.minimum) > 0 || cached(span.minimum) != nullptr)
+            continue;
+
+        size_t blockLen = blockLength(span);
+        reading.insert(span.minimum);
+        pool.start(new PrefetchTask([this, span, blockLen]() {
+            auto buffer = read(span.minimum, blockLen);
+            QMutexLocker locker(&mutex);
+            finishRead(span, buffer);
+        }));
+    }
+}
+
+void BufferedFile::setPreload(bool enabled)
+{
+    if (enabled)
+        prefetch(0, size());
+}
+
+// Called with mutex held
+void BufferedFile::finishRead(range_t<size_t> span, std::shared_ptr<Buffer> buffer)
+{
+    reading.erase(span.minimum);
+    blockRead.wakeAll();
+
+    // Don't keep blocks that the file has grown or shrunk past while
+    // they were being read
+    if (buffer == nullptr || span.minimum >= fileSize || cached(span.minimum) != nullptr)
+        return;
+    if (buffer->length != blockLength(blockSpan(span.minimum)))
+        return;
+
+    blocks.push_front(buffer);
+    while (blocks.size() > (size_t)maxBlocks)
+        blocks.pop_back();
+}
+
+std::shared_ptr<BufferedFile::Buffer> BufferedFile::read(size_t offset, size_t length)
+{
+    TraceScope trace("BufferedFile::read");
+    std::unique_ptr<uchar[]> storage(new uchar[length]);
+    if (!readBlock(storage.get(), offset, length))
+        return nullptr;
+    return std::make_shared<Buffer>(std::move(storage), offset, length);
+}
+
+bool BufferedFile::readBlock(uchar *dest, size_t offset, size_t length)
+{
+    return readAt(dest, offset, length);
+}
+
+bool BufferedFile::readAt(uchar *dest, size_t offset, size_t length)
+{
+#ifdef Q_OS_UNIX
+    // pread doesn't move the file position, so can be used from many
+    // threads at once
+    int fd = file->handle();
+    while (length > 0) {
+        auto n = pread(fd, dest, length, offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        dest += n;
+        offset += n;
+        length -= n;
+    }
+    return true;
+#else
+    QMutexLocker locker(&fileMutex);
+    if (!file->seek(offset))
+        return false;
+    return file->read(reinterpret_cast<char*>(dest), length) == (qint64)length;
+#endif
+}
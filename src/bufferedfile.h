@@ -0,0 +1,107 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <list>
+#include <memory>
+#include <set>
+#include "filereader.h"
+#include "util.h"
+
+/*
+ * Reads a file in large aligned blocks into an LRU cache, for storage
+ * where mmap is slow or not supported (e.g. some FUSE and network
+ * filesystems). Prefetched blocks are read by a small pool of threads of
+ * its own, so slow reads never hold up the tile workers.
+ *
+ * Subclasses can lay blocks out differently and produce them some other
+ * way, e.g. by decompressing them, and still share the cache and pool.
+ */
+class BufferedFile : public FileReader
+{
+public:
+    static const size_t defaultBlockSize = 4 * 1024 * 1024;
+    static const int defaultMaxBlocks = 64;
+    static const int readThreads = 4;
+
+    // Each block also holds the first overlap bytes of the next one. file
+    // must stay open for the lifetime of the BufferedFile.
+    BufferedFile(QFile *file, size_t overlap, size_t blockSize = defaultBlockSize, int maxBlocks = defaultMaxBlocks);
+    ~BufferedFile();
+
+    size_t size() override;
+    void resize(size_t size) override;
+    std::shared_ptr<const Block> block(size_t offset) override;
+    void prefetch(size_t offset, size_t length) override;
+    void setPreload(bool enabled) override;
+
+protected:
+    QFile *file;
+
+    // Must be called before the first block is read, by subclasses whose
+    // size isn't the size of the file, with how many of their blocks to
+    // cache
+    void setSize(size_t size, int maxBlocks);
+    // Bytes [offset, offset + length) of the file, from any thread
+    bool readAt(uchar *dest, size_t offset, size_t length);
+    // The bytes of the block at offset, excluding the overlap, for an
+    // offset < size(). Called with mutex held.
+    virtual range_t<size_t> blockSpan(size_t offset);
+    // Produce bytes [offset, offset + length) of a block, from any thread
+    virtual bool readBlock(uchar *dest, size_t offset, size_t length);
+    // Stop waiting for threads reading blocks, before the subclass that
+    // reads them is destroyed
+    void stopReading();
+
+private:
+    struct Buffer : Block
+    {
+        Buffer(std::unique_ptr<uchar[]> storage, size_t offset, size_t length)
+            : Block(storage.get(), offset, length), storage(std::move(storage)) { };
+
+        std::unique_ptr<uchar[]> storage;
+    };
+
+    size_t fileSize;
+    size_t overlap;
+    size_t blockSize;
+    int maxBlocks;
+
+    // Protects everything below, and fileSize
+    QMutex mutex;
+    // Signalled whenever a block finishes being read
+    QWaitCondition blockRead;
+    // Most recently used first
+    std::list<std::shared_ptr<Buffer>> blocks;
+    // Offsets of blocks being read
+    std::set<size_t> reading;
+    // Only used where pread isn't available
+    QMutex fileMutex;
+    QThreadPool pool;
+
+    size_t blockLength(range_t<size_t> span);
+    std::shared_ptr<Buffer> cached(size_t offset);
+    std::shared_ptr<Buffer> read(size_t offset, size_t length);
+    void finishRead(range_t<size_t> span, std::shared_ptr<Buffer> buffer);
+};
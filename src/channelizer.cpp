@@ -0,0 +1,269 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "channelizer.h"
+#include <QMutexLocker>
+#include <liquid/liquid.h>
+#include <algorithm>
+#include <numeric>
+#include <string.h>
+
+Channelizer::Channelizer(std::shared_ptr<SampleSource<std::complex<float>>> src, int channels, int tapsPerChannel)
+    : src(src), channels(channels), tapsPerChannel(tapsPerChannel)
+{
+    // Prototype lowpass with its cutoff at the channel edge
+    auto len = channels * tapsPerChannel;
+    auto taps = std::vector<float>(len);
+    liquid_firdes_kaiser(len, 0.5f / channels, 60.0f, 0.0f, taps.data());
+
+    // Unity gain at DC, so a tone keeps its amplitude in its channel
+    float sum = std::accumulate(taps.begin(), taps.end(), 0.0f);
+    polyphaseTaps.resize(len);
+    for (int p = 0; p < channels; p++) {
+        for (int j = 0; j < tapsPerChannel; j++) {
+            polyphaseTaps[p * tapsPerChannel + j] = taps[j * channels + p] / sum;
+        }
+    }
+
+    outputs.resize(channels);
+    src->subscribe(this);
+}
+
+Channelizer::~Channelizer()
+{
+    src->unsubscribe(this);
+}
+
+void Channelizer::invalidateEvent(const Invalidation &invalidation)
+{
+    auto outputInvalidation = invalidation;
+    if (invalidation.type == Invalidation::Samples) {
+        // Output n uses inputs up to a filter length before n * channels
+        const size_t history = channels * tapsPerChannel - 1;
+        auto end = invalidation.range.maximum;
+        end = end > SIZE_MAX - history ? SIZE_MAX : end + history;
+        outputInvalidation = Invalidation::samples(invalidation.range.minimum / channels, end / channels + 1);
+    }
+
+    {
+        QMutexLocker ml(&mutex);
+        for (auto it = blocks.begin(); it != blocks.end();) {
+            if (outputInvalidation.affects((*it)->start, (*it)->start + (*it)->length))
+                it = blocks.erase(it);
+            else
+                it++;
+        }
+        generation++;
+    }
+
+    for (auto &weak : outputs) {
+        if (auto output = weak.lock())
+            output->invalidateEvent(outputInvalidation);
+    }
+}
+
+std::shared_ptr<SampleSource<std::complex<float>>> Channelizer::channel(int index)
+{
+    if (index < 0 || index >= channels)
+        return nullptr;
+
+    auto output = outputs[index].lock();
+    if (!output) {
+        output = std::make_shared<ChannelizerOutput>(shared_from_this(), index);
+        outputs[index] = output;
+    }
+    return output;
+}
+
+double Channelizer::channelFrequency(int index)
+{
+    double offset = (double)index / channels;
+    if (offset > 0.5)
+        offset -= 1.0;
+    return src->getFrequency() + offset * src->rate();
+}
+
+size_t Channelizer::count()
+{
+    return src->count() / channels;
+}
+
+double Channelizer::rate()
+{
+    return src->rate() / channels;
+}
+
+std::unique_ptr<std::complex<float>[]> Channelizer::getSamples(int index, size_t start, size_t length)
+{
+    if (length == 0)
+        return std::make_unique<std::complex<float>[]>(0);
+
+    auto block = getBlock(start, length);
+    if (block == nullptr)
+        return nullptr;
+
+    auto dest = std::make_unique<std::complex<float>[]>(length);
+    auto samples = &block->samples[index * block->length + (start - block->start)];
+    memcpy(dest.get(), samples, length * sizeof(std::complex<float>));
+    return dest;
+}
+
+std::shared_ptr<const Channelizer::Block> Channelizer::getBlock(size_t start, size_t length)
+{
+    if (length == 0 || start + length > count())
+        return nullptr;
+
+    // Every channel of a tile asks for the same range, so the first request
+    // computes the rest of them too
+    size_t computedGeneration;
+    {
+        QMutexLocker ml(&mutex);
+        auto block = findBlock(start, length);
+        if (block != nullptr)
+            return block;
+        computedGeneration = generation;
+    }
+
+    // The filter and FFTs run unlocked, so workers asking for other ranges
+    // aren't held up
+    auto block = computeBlock(start, length);
+    if (block == nullptr)
+        return nullptr;
+
+    QMutexLocker ml(&mutex);
+    if (generation != computedGeneration)
+        return block;
+    // Another thread may have computed the same range in the meantime
+    auto existing = findBlock(start, length);
+    if (existing != nullptr)
+        return existing;
+
+    blocks.push_front(block);
+    size_t cached = 0;
+    for (auto it = blocks.begin(); it != blocks.end(); it++) {
+        cached += (*it)->length * channels;
+        if (cached > maxCachedSamples && it != blocks.begin()) {
+            blocks.erase(it, blocks.end());
+            break;
+        }
+    }
+    return block;
+}
+
+std::shared_ptr<const Channelizer::Block> Channelizer::findBlock(size_t start, size_t length)
+{
+    for (auto it = blocks.begin(); it != blocks.end(); it++) {
+        if (start >= (*it)->start && start + length <= (*it)->start + (*it)->length) {
+            blocks.splice(blocks.begin(), blocks, it);
+            return blocks.front();
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const Channelizer::Block> Channelizer::computeBlock(size_t start, size_t length)
+{
+    // Output n uses inputs n * channels - i for every tap i, so read the
+    // whole filter length of history before the first output
+    const ssize_t history = channels * tapsPerChannel - 1;
+    const ssize_t inputStart = (ssize_t)(start * channels) - history;
+    const size_t inputLength = (length - 1) * channels + 1 + history;
+    auto input = std::make_unique<std::complex<float>[]>(inputLength);
+    const size_t skip = std::max(-inputStart, (ssize_t)0);
+    if (skip < inputLength) {
+        auto samples = src->getSamples(inputStart + skip, inputLength - skip);
+        if (samples == nullptr)
+            return nullptr;
+        memcpy(&input[skip], samples.get(), (inputLength - skip) * sizeof(std::complex<float>));
+    }
+
+    auto block = std::make_shared<Block>();
+    block->start = start;
+    block->length = length;
+    block->samples = std::make_unique<std::complex<float>[]>(length * channels);
+
+    std::unique_ptr<FFT> fft;
+    {
+        QMutexLocker ml(&mutex);
+        if (!ffts.empty()) {
+            fft = std::move(ffts.back());
+            ffts.pop_back();
+        }
+    }
+    if (fft == nullptr)
+        fft = std::make_unique<FFT>(channels);
+
+    auto branches = std::make_unique<std::complex<float>[]>(channels);
+    for (size_t n = 0; n < length; n++) {
+        // Filter each branch at its own phase
+        const auto newest = &input[n * channels + history];
+        for (int p = 0; p < channels; p++) {
+            const float *h = &polyphaseTaps[p * tapsPerChannel];
+            const std::complex<float> *x = newest - p;
+            std::complex<float> acc = 0;
+            for (int j = 0; j < tapsPerChannel; j++) {
+                acc += h[j] * *x;
+                x -= channels;
+            }
+            branches[p] = acc;
+        }
+
+        // A forward FFT across the branches gives channel k in bin -k
+        fft->process(branches.get(), branches.get());
+        for (int k = 0; k < channels; k++) {
+            block->samples[k * length + n] = branches[(channels - k) % channels];
+        }
+    }
+
+    QMutexLocker ml(&mutex);
+    ffts.push_back(std::move(fft));
+    return block;
+}
+
+ChannelizerOutput::ChannelizerOutput(std::shared_ptr<Channelizer> channelizer, int index)
+    : channelizer(channelizer), index(index)
+{
+    frequency = channelizer->channelFrequency(index);
+}
+
+void ChannelizerOutput::invalidateEvent(const Invalidation &invalidation)
+{
+    frequency = channelizer->channelFrequency(index);
+    invalidate(invalidation);
+}
+
+std::unique_ptr<std::complex<float>[]> ChannelizerOutput::getSamples(size_t start, size_t length)
+{
+    return channelizer->getSamples(index, start, length);
+}
+
+size_t ChannelizerOutput::count()
+{
+    return channelizer->count();
+}
+
+double ChannelizerOutput::rate()
+{
+    return channelizer->rate();
+}
+
+float ChannelizerOutput::relativeBandwidth()
+{
+    return 1;
+}
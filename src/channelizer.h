@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QMutex>
+#include <complex>
+#include <list>
+#include <memory>
+#include <vector>
+#include "fft.h"
+#include "samplesource.h"
+
+class ChannelizerOutput;
+
+/*
+ * Splits a complex source into `channels` equally spaced sub-bands with a
+ * critically sampled polyphase filterbank followed by a single FFT, so all
+ * channels are produced in one pass over the input.
+ *
+ * Channel k is centred on k / channels cycles per input sample (channels
+ * above channels / 2 are the negative frequencies) and runs at
+ * 1 / channels of the input rate.
+ */
+class Channelizer : public Subscriber, public std::enable_shared_from_this<Channelizer>
+{
+public:
+    Channelizer(std::shared_ptr<SampleSource<std::complex<float>>> src, int channels, int tapsPerChannel = 8);
+    ~Channelizer();
+    void invalidateEvent(const Invalidation &invalidation) override;
+    std::shared_ptr<SampleSource<std::complex<float>>> channel(int index);
+    int channelCount() { return channels; };
+    double channelFrequency(int index);
+    std::unique_ptr<std::complex<float>[]> getSamples(int index, size_t start, size_t length);
+    size_t count();
+    double rate();
+
+private:
+    struct Block {
+        size_t start;
+        size_t length;
+        // All channels for [start, start + length), one channel after another
+        std::unique_ptr<std::complex<float>[]> samples;
+    };
+
+    // Computed samples, of all channels, to keep around for the other
+    // channels. The newest block is always kept.
+    static const size_t maxCachedSamples = 1 << 22;
+
+    std::shared_ptr<SampleSource<std::complex<float>>> src;
+    int channels;
+    int tapsPerChannel;
+    // Prototype filter, rearranged so each branch's taps are contiguous
+    std::vector<float> polyphaseTaps;
+    std::vector<std::weak_ptr<ChannelizerOutput>> outputs;
+    // Blocks are computed without holding mutex, so several can be at once.
+    // Each takes an FFT from ffts, or makes one if none are free.
+    std::vector<std::unique_ptr<FFT>> ffts;
+    std::list<std::shared_ptr<const Block>> blocks;
+    // Incremented by invalidations, so blocks computed from old samples
+    // aren't cached
+    size_t generation = 0;
+    // Protects ffts, blocks and generation
+    QMutex mutex;
+
+    std::shared_ptr<const Block> getBlock(size_t start, size_t length);
+    // Called with mutex held
+    std::shared_ptr<const Block> findBlock(size_t start, size_t length);
+    std::shared_ptr<const Block> computeBlock(size_t start, size_t length);
+};
+
+class ChannelizerOutput : public SampleSource<std::complex<float>>
+{
+public:
+    ChannelizerOutput(std::shared_ptr<Channelizer> channelizer, int index);
+    void invalidateEvent(const Invalidation &invalidation) override;
+    std::unique_ptr<std::complex<float>[]> getSamples(size_t start, size_t length) override;
+    size_t count() override;
+    double rate() override;
+    float relativeBandwidth() override;
+
+private:
+    std::shared_ptr<Channelizer> channelizer;
+    int index;
+};
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include "channelizer.h"
+#include "util.h"
+
+/*
+ * Checks that a tone at the centre of each channel comes out of that
+ * channel at full amplitude, and is filtered out of all the others.
+ */
+
+class ToneSource : public SampleSource<std::complex<float>>
+{
+public:
+    ToneSource(double cyclesPerSample, size_t length) : cyclesPerSample(cyclesPerSample), length(length) { };
+
+    std::unique_ptr<std::complex<float>[]> getSamples(size_t start, size_t length) override {
+        auto samples = std::make_unique<std::complex<float>[]>(length);
+        for (size_t i = 0; i < length; i++) {
+            samples[i] = std::polar(1.0, Tau * cyclesPerSample * (start + i));
+        }
+        return samples;
+    }
+    size_t count() override { return length; };
+    double rate() override { return 1; };
+    float relativeBandwidth() override { return 1; };
+
+private:
+    double cyclesPerSample;
+    size_t length;
+};
+
+static int failures = 0;
+
+static void check(bool condition, const char *what, int channels, int tone, int channel, float value)
+{
+    if (!condition) {
+        fprintf(stderr, "FAIL: %s (%d channels, tone in channel %d, channel %d: %.2f dB)\n",
+                what, channels, tone, channel, value);
+        failures++;
+    }
+}
+
+// Mean power of channel, in dB, past the filter's start-up
+static float channelPower(Channelizer &channelizer, int channel)
+{
+    const size_t start = 64, length = 256;
+    auto samples = channelizer.channel(channel)->getSamples(start, length);
+    if (samples == nullptr)
+        return NAN;
+    double power = 0;
+    for (size_t i = 0; i < length; i++) {
+        power += std::norm(samples[i]);
+    }
+    return 10 * std::log10(power / length);
+}
+
+int main()
+{
+    for (int channels : {4, 8, 16}) {
+        for (int tone = 0; tone < channels; tone++) {
+            auto source = std::make_shared<ToneSource>((double)tone / channels, 400 * channels);
+            auto channelizer = std::make_shared<Channelizer>(source, channels);
+
+            for (int channel = 0; channel < channels; channel++) {
+                float power = channelPower(*channelizer, channel);
+                if (channel == tone)
+                    check(std::abs(power) < 0.5f, "tone not at full amplitude in its channel", channels, tone, channel, power);
+                else
+                    check(power < -40, "tone not filtered out of another channel", channels, tone, channel, power);
+            }
+        }
+    }
+
+    // Channels above channels / 2 are below the centre frequency
+    auto source = std::make_shared<ToneSource>(-1.0 / 8, 3200);
+    auto channelizer = std::make_shared<Channelizer>(source, 8);
+    float power = channelPower(*channelizer, 7);
+    check(std::abs(power) < 0.5f, "negative frequency tone not in the top channel", 8, -1, 7, power);
+
+    auto channel = channelizer->channel(0);
+    if (channel->count() != 400 || channel->rate() != 1.0 / 8) {
+        fprintf(stderr, "FAIL: channel count or rate\n");
+        failures++;
+    }
+    if (channel->getSamples(10, 0) == nullptr) {
+        fprintf(stderr, "FAIL: empty request\n");
+        failures++;
+    }
+    if (channel->getSamples(399, 2) != nullptr) {
+        fprintf(stderr, "FAIL: request past the end\n");
+        failures++;
+    }
+
+    if (failures == 0)
+        printf("channelizer: all tests passed\n");
+    return failures == 0 ? 0 : 1;
+}
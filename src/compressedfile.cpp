@@ -0,0 +1,307 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+#include "compressedfile.h"
+#include "tracing.h"
+
+#ifdef INSPECTRUM_ZLIB
+#include <zlib.h>
+#endif
+#ifdef INSPECTRUM_ZSTD
+#include <zstd.h>
+#endif
+
+// Cache about as much decompressed data as BufferedFile does for a file
+static int maxBlocksFor(size_t averageBlock)
+{
+    const size_t cacheSize = BufferedFile::defaultBlockSize * BufferedFile::defaultMaxBlocks;
+    return std::min<size_t>(std::max<size_t>(cacheSize / std::max<size_t>(averageBlock, 1), 8), 1024);
+}
+
+std::unique_ptr<FileReader> openCompressedFile(QFile *file, const std::string &compression)
+{
+    if (compression == "gz") {
+#ifdef INSPECTRUM_ZLIB
+        return std::make_unique<GzipFile>(file);
+#else
+        throw std::runtime_error("inspectrum was built without gzip support");
+#endif
+    }
+    if (compression == "zst") {
+#ifdef INSPECTRUM_ZSTD
+        return std::make_unique<ZstdFile>(file);
+#else
+        throw std::runtime_error("inspectrum was built without zstd support");
+#endif
+    }
+    throw std::runtime_error("Unsupported compression: " + compression);
+}
+
+#ifdef INSPECTRUM_ZLIB
+GzipFile::GzipFile(QFile *file) : BufferedFile(file, 0), compressedSize(file->size())
+{
+    // Decompressed data between access points, keeping the windows to no
+    // more than about 1/500th of the data for huge files
+    const size_t span = std::max<size_t>(16 * 1024 * 1024, compressedSize / 4096);
+    buildIndex(span);
+}
+
+GzipFile::~GzipFile()
+{
+    stopReading();
+}
+
+void GzipFile::buildIndex(size_t span)
+{
+    TraceScope trace("GzipFile::buildIndex");
+    const size_t chunkSize = 1024 * 1024;
+    std::unique_ptr<uchar[]> input(new uchar[chunkSize]);
+    std::unique_ptr<uchar[]> window(new uchar[windowSize]());
+
+    z_stream strm = {};
+    // Automatically detect gzip or zlib headers
+    if (inflateInit2(&strm, 47) != Z_OK)
+        throw std::runtime_error("Error initialising zlib");
+
+    size_t readOffset = 0;
+    size_t totalIn = 0;
+    size_t totalOut = 0;
+    size_t last = 0;
+    bool memberStart = true;
+    bool streamEnd = false;
+    while (true) {
+        if (strm.avail_in == 0) {
+            if (readOffset >= compressedSize)
+                break;
+            size_t n = std::min(chunkSize, compressedSize - readOffset);
+            if (!readAt(input.get(), readOffset, n)) {
+                inflateEnd(&strm);
+                throw std::runtime_error("Error reading file");
+            }
+            readOffset += n;
+            strm.next_in = input.get();
+            strm.avail_in = n;
+        }
+        if (strm.avail_out == 0) {
+            strm.next_out = window.get();
+            strm.avail_out = windowSize;
+        }
+
+        totalIn += strm.avail_in;
+        totalOut += strm.avail_out;
+        int ret = inflate(&strm, Z_BLOCK);
+        totalIn -= strm.avail_in;
+        totalOut -= strm.avail_out;
+
+        if (ret == Z_STREAM_END) {
+            // Carry on into the next member, if there is one
+            inflateReset(&strm);
+            memberStart = true;
+            streamEnd = true;
+            continue;
+        }
+        if (ret == Z_DATA_ERROR && memberStart && streamEnd) {
+            // Padding after the last member, which gzip also ignores
+            break;
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            inflateEnd(&strm);
+            throw std::runtime_error("gzip data is corrupt");
+        }
+        if (strm.total_out > 0)
+            memberStart = false;
+        streamEnd = false;
+
+        // Decompression can restart at the end of any block but the last
+        if ((strm.data_type & 128) && !(strm.data_type & 64) && (totalOut == 0 || totalOut - last > span)) {
+            AccessPoint point{totalOut, totalIn, strm.data_type & 7, std::unique_ptr<uchar[]>(new uchar[windowSize])};
+            // window is circular, with the oldest output where the next
+            // output will go
+            size_t left = strm.avail_out;
+            memcpy(point.window.get(), window.get() + windowSize - left, left);
+            memcpy(point.window.get() + left, window.get(), windowSize - left);
+            points.push_back(std::move(point));
+            last = totalOut;
+        }
+    }
+    inflateEnd(&strm);
+
+    if (!streamEnd)
+        throw std::runtime_error("gzip file is truncated");
+
+    decompressedSize = totalOut;
+    setSize(decompressedSize, maxBlocksFor(span));
+}
+
+size_t GzipFile::pointFor(size_t offset)
+{
+    auto it = std::upper_bound(points.begin(), points.end(), offset,
+        [](size_t offset, const AccessPoint &point) { return offset < point.out; });
+    return it - points.begin() - 1;
+}
+
+range_t<size_t> GzipFile::blockSpan(size_t offset)
+{
+    size_t i = pointFor(offset);
+    return {points[i].out, i + 1 < points.size() ? points[i + 1].out : decompressedSize};
+}
+
+bool GzipFile::readBlock(uchar *dest, size_t offset, size_t length)
+{
+    size_t i = pointFor(offset);
+    const auto &point = points[i];
+
+    // Up to and including the partial byte at the next access point
+    size_t inStart = point.in - (point.bits ? 1 : 0);
+    size_t inEnd = i + 1 < points.size() ? std::min(points[i + 1].in + 1, compressedSize) : compressedSize;
+    std::unique_ptr<uchar[]> input(new uchar[inEnd - inStart]);
+    if (!readAt(input.get(), inStart, inEnd - inStart))
+        return false;
+
+    z_stream strm = {};
+    if (inflateInit2(&strm, -15) != Z_OK)
+        return false;
+    strm.next_in = input.get();
+    strm.avail_in = inEnd - inStart;
+    if (point.bits) {
+        inflatePrime(&strm, point.bits, input[0] >> (8 - point.bits));
+        strm.next_in++;
+        strm.avail_in--;
+    }
+    inflateSetDictionary(&strm, point.window.get(), windowSize);
+
+    strm.next_out = dest;
+    strm.avail_out = length;
+    bool raw = true;
+    bool ok = true;
+    while (ok && strm.avail_out > 0) {
+        int ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            if (strm.avail_out == 0)
+                break;
+
+            // A raw stream stops before the member's trailer, and later
+            // members start with a header
+            if (raw) {
+                if (strm.avail_in < 8) {
+                    ok = false;
+                    break;
+                }
+                strm.next_in += 8;
+                strm.avail_in -= 8;
+                raw = false;
+            }
+            inflateReset2(&strm, 31);
+        } else if (ret != Z_OK) {
+            ok = false;
+        }
+    }
+    inflateEnd(&strm);
+    return ok;
+}
+#endif
+
+#ifdef INSPECTRUM_ZSTD
+static uint32_t readLE32(const uchar *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+ZstdFile::ZstdFile(QFile *file) : BufferedFile(file, 0)
+{
+    readSeekTable();
+}
+
+ZstdFile::~ZstdFile()
+{
+    stopReading();
+}
+
+void ZstdFile::readSeekTable()
+{
+    const uint32_t skippableMagic = 0x184D2A5E;
+    const uint32_t seekableMagic = 0x8F92EAB1;
+    const size_t footerSize = 9;
+    const size_t fileSize = file->size();
+    const std::runtime_error notSeekable("zstd file is not in the seekable format, so can't be read without decompressing it first");
+
+    uchar footer[footerSize];
+    if (fileSize < footerSize + 8 || !readAt(footer, fileSize - footerSize, footerSize))
+        throw notSeekable;
+    if (readLE32(footer + 5) != seekableMagic)
+        throw notSeekable;
+
+    size_t frameCount = readLE32(footer);
+    size_t entrySize = (footer[4] & 0x80) ? 12 : 8;
+    size_t tableSize = frameCount * entrySize;
+    if (tableSize + footerSize + 8 > fileSize)
+        throw std::runtime_error("zstd seek table is corrupt");
+
+    // The table is the contents of a skippable frame at the end of the file
+    size_t tableStart = fileSize - footerSize - tableSize;
+    uchar header[8];
+    if (!readAt(header, tableStart - 8, 8) || readLE32(header) != skippableMagic || readLE32(header + 4) != tableSize + footerSize)
+        throw std::runtime_error("zstd seek table is corrupt");
+
+    std::vector<uchar> table(tableSize);
+    if (!readAt(table.data(), tableStart, tableSize))
+        throw std::runtime_error("Error reading file");
+
+    size_t in = 0;
+    for (size_t i = 0; i < frameCount; i++) {
+        size_t compressed = readLE32(&table[i * entrySize]);
+        size_t decompressed = readLE32(&table[i * entrySize + 4]);
+        if (decompressed > 0)
+            frames.push_back({decompressedSize, in, compressed});
+        in += compressed;
+        decompressedSize += decompressed;
+    }
+    if (in != tableStart - 8)
+        throw std::runtime_error("zstd seek table does not match the file");
+
+    setSize(decompressedSize, maxBlocksFor(decompressedSize / std::max<size_t>(frames.size(), 1)));
+}
+
+size_t ZstdFile::frameFor(size_t offset)
+{
+    auto it = std::upper_bound(frames.begin(), frames.end(), offset,
+        [](size_t offset, const Frame &frame) { return offset < frame.out; });
+    return it - frames.begin() - 1;
+}
+
+range_t<size_t> ZstdFile::blockSpan(size_t offset)
+{
+    size_t i = frameFor(offset);
+    return {frames[i].out, i + 1 < frames.size() ? frames[i + 1].out : decompressedSize};
+}
+
+bool ZstdFile::readBlock(uchar *dest, size_t offset, size_t length)
+{
+    const auto &frame = frames[frameFor(offset)];
+    std::unique_ptr<uchar[]> input(new uchar[frame.length]);
+    if (!readAt(input.get(), frame.in, frame.length))
+        return false;
+
+    size_t ret = ZSTD_decompress(dest, length, input.get(), frame.length);
+    return !ZSTD_isError(ret) && ret == length;
+}
+#endif
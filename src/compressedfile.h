@@ -0,0 +1,114 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "bufferedfile.h"
+
+/*
+ * Random access to compressed captures, without decompressing them first.
+ * The file is split into blocks that can each be decompressed on their
+ * own, which BufferedFile caches and decompresses in parallel ahead of
+ * scrolling.
+ */
+
+// A reader for file, compressed with compression ("gz" or "zst"). Throws
+// std::runtime_error if the file can't be read that way.
+std::unique_ptr<FileReader> openCompressedFile(QFile *file, const std::string &compression);
+
+#ifdef INSPECTRUM_ZLIB
+/*
+ * gzip (or zlib) files, which have no index of their own. Decompressing
+ * the whole file once when it's opened finds places that decompression
+ * can restart from, at deflate block boundaries, saving the 32 KiB of
+ * output before each one that later data may refer back to.
+ * Concatenated gzip members (e.g. from bgzip) are read as one stream.
+ */
+class GzipFile : public BufferedFile
+{
+public:
+    GzipFile(QFile *file);
+    ~GzipFile();
+
+    void resize(size_t size) override { };
+    bool resizable() override { return false; };
+
+protected:
+    range_t<size_t> blockSpan(size_t offset) override;
+    bool readBlock(uchar *dest, size_t offset, size_t length) override;
+
+private:
+    static const int windowSize = 32768;
+
+    struct AccessPoint
+    {
+        // Decompressed offset, and the compressed offset of the first
+        // whole byte after it, with bits bits of the byte before
+        size_t out;
+        size_t in;
+        int bits;
+        std::unique_ptr<uchar[]> window;
+    };
+
+    size_t compressedSize;
+    size_t decompressedSize = 0;
+    std::vector<AccessPoint> points;
+
+    void buildIndex(size_t span);
+    size_t pointFor(size_t offset);
+};
+#endif
+
+#ifdef INSPECTRUM_ZSTD
+/*
+ * zstd files in the seekable format, which are made of independent frames
+ * and end with a seek table listing their sizes.
+ */
+class ZstdFile : public BufferedFile
+{
+public:
+    ZstdFile(QFile *file);
+    ~ZstdFile();
+
+    void resize(size_t size) override { };
+    bool resizable() override { return false; };
+
+protected:
+    range_t<size_t> blockSpan(size_t offset) override;
+    bool readBlock(uchar *dest, size_t offset, size_t length) override;
+
+private:
+    struct Frame
+    {
+        // Decompressed and compressed offsets, and compressed length
+        size_t out;
+        size_t in;
+        size_t length;
+    };
+
+    size_t decompressedSize = 0;
+    std::vector<Frame> frames;
+
+    void readSeekTable();
+    size_t frameFor(size_t offset);
+};
+#endif
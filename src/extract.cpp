@@ -0,0 +1,233 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+
+#include <chrono>
+#include <liquid/liquid.h>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include "channelizer.h"
+#include "inputsource.h"
+#include "sampleexporter.h"
+#include "tunertransform.h"
+
+/*
+ * Extracts one channel of a recording without a display: tunes to an
+ * offset, low-pass filters to a bandwidth and decimates, the same way as
+ * exporting the tuner output from the GUI. Or, with --channels, takes one
+ * output of a polyphase channelizer, as "Split into channels" does.
+ *
+ * Each export thread has its own TunerTransform or Channelizer, so the
+ * chunks are filtered in parallel. A tuner reset at a chunk boundary is
+ * warmed up with a full filter length of earlier samples, so the output is
+ * seamless.
+ */
+
+static bool formatFromName(const std::string &name, ExportFormat &format)
+{
+    if (name == "cf32" || name == "fc32" || name == "cfile" || name == "sigmf-data")
+        format = ExportFormat::Float32;
+    else if (name == "cs16" || name == "sc16" || name == "c16")
+        format = ExportFormat::Int16;
+    else if (name == "cs8" || name == "sc8" || name == "c8")
+        format = ExportFormat::Int8;
+    else if (name == "cu8" || name == "uc8")
+        format = ExportFormat::Uint8;
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("inspectrum-extract");
+    a.setOrganizationName("inspectrum");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Extract a tuned, filtered and decimated channel from a recording");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", QCoreApplication::translate("main", "File to read."));
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "File to write. A SigMF meta file is written alongside."));
+
+    QCommandLineOption formatOption(QStringList() << "f" << "format",
+                                  QCoreApplication::translate("main", "Set input file format, as for inspectrum."),
+                                  QCoreApplication::translate("main", "fmt"));
+    parser.addOption(formatOption);
+    QCommandLineOption rateOption(QStringList() << "r" << "rate",
+                                  QCoreApplication::translate("main", "Set sample rate, if the file doesn't specify it."),
+                                  QCoreApplication::translate("main", "Hz"));
+    parser.addOption(rateOption);
+    QCommandLineOption offsetOption(QStringList() << "o" << "offset",
+                                  QCoreApplication::translate("main", "Centre of the channel, relative to the centre of the recording (default 0)."),
+                                  QCoreApplication::translate("main", "Hz"), "0");
+    parser.addOption(offsetOption);
+    QCommandLineOption bandwidthOption(QStringList() << "b" << "bandwidth",
+                                  QCoreApplication::translate("main", "Channel bandwidth."),
+                                  QCoreApplication::translate("main", "Hz"));
+    parser.addOption(bandwidthOption);
+    QCommandLineOption decimationOption(QStringList() << "d" << "decimation",
+                                  QCoreApplication::translate("main", "Decimation factor (default sample rate / bandwidth)."),
+                                  QCoreApplication::translate("main", "n"));
+    parser.addOption(decimationOption);
+    QCommandLineOption channelsOption(QStringList() << "channels",
+                                  QCoreApplication::translate("main", "Split the recording into n equally spaced channels, each at 1/n of the sample rate, instead of tuning with --offset and --bandwidth."),
+                                  QCoreApplication::translate("main", "n"));
+    parser.addOption(channelsOption);
+    QCommandLineOption channelOption(QStringList() << "channel",
+                                  QCoreApplication::translate("main", "Channel to extract with --channels. Channel k is centred k/n of the sample rate above the centre of the recording, and channels above n/2 wrap round below it (default 0)."),
+                                  QCoreApplication::translate("main", "k"), "0");
+    parser.addOption(channelOption);
+    QCommandLineOption outputFormatOption(QStringList() << "output-format",
+                                  QCoreApplication::translate("main", "Output format: cf32, cs16, cs8 or cu8 (default from the output file suffix, or cf32)."),
+                                  QCoreApplication::translate("main", "fmt"));
+    parser.addOption(outputFormatOption);
+    QCommandLineOption scaleOption(QStringList() << "scale",
+                                  QCoreApplication::translate("main", "Gain applied before converting to integers (default 1)."),
+                                  QCoreApplication::translate("main", "gain"), "1");
+    parser.addOption(scaleOption);
+    QCommandLineOption ditherOption(QStringList() << "dither",
+                                  QCoreApplication::translate("main", "Dither when converting to integers."));
+    parser.addOption(ditherOption);
+    QCommandLineOption startOption(QStringList() << "start",
+                                  QCoreApplication::translate("main", "First sample to extract (default 0)."),
+                                  QCoreApplication::translate("main", "sample"), "0");
+    parser.addOption(startOption);
+    QCommandLineOption lengthOption(QStringList() << "length",
+                                  QCoreApplication::translate("main", "Number of input samples to extract (default to the end of the file)."),
+                                  QCoreApplication::translate("main", "samples"));
+    parser.addOption(lengthOption);
+
+    parser.process(a);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2 || (!parser.isSet(bandwidthOption) && !parser.isSet(channelsOption)))
+        parser.showHelp(1);
+
+    auto parse = [&](const QCommandLineOption &option, const char *name) {
+        bool ok;
+        auto value = parser.value(option).toDouble(&ok);
+        if (!ok) {
+            fprintf(stderr, "ERROR: could not parse %s\n", name);
+            exit(1);
+        }
+        return value;
+    };
+
+    auto input = std::make_shared<InputSource>();
+    if (parser.isSet(formatOption))
+        input->setFormat(parser.value(formatOption).toStdString());
+
+    try {
+        input->openFile(args.at(0).toUtf8().constData());
+        if (parser.isSet(rateOption))
+            input->setSampleRate(parse(rateOption, "rate"));
+        if (input->rate() <= 0)
+            throw std::runtime_error("Sample rate unknown, set it with --rate");
+        if (input->realSignal())
+            throw std::runtime_error("Channel extraction needs a complex recording");
+
+        const double rate = input->rate();
+        size_t start = parse(startOption, "start");
+        if (start >= input->count())
+            throw std::runtime_error("Start is past the end of the file");
+        size_t end = input->count();
+        if (parser.isSet(lengthOption))
+            end = std::min(start + (size_t)parse(lengthOption, "length"), end);
+
+        auto outputFilename = args.at(1);
+        // Unknown suffixes get floats, but an unknown --output-format is an error
+        auto format = ExportFormat::Float32;
+        if (parser.isSet(outputFormatOption)) {
+            auto name = parser.value(outputFormatOption).toStdString();
+            if (!formatFromName(name, format))
+                throw std::runtime_error("Unsupported output format " + name);
+        } else {
+            formatFromName(QFileInfo(outputFilename).suffix().toLower().toStdString(), format);
+        }
+
+        const unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<std::shared_ptr<SampleSource<std::complex<float>>>> sources;
+        int decimation = 1;
+        if (parser.isSet(channelsOption)) {
+            const int channels = parse(channelsOption, "channels");
+            const int channel = parse(channelOption, "channel");
+            if (channels < 2)
+                throw std::runtime_error("There must be at least 2 channels");
+            if (channel < 0 || channel >= channels)
+                throw std::runtime_error("Channel must be between 0 and channels - 1");
+
+            // The channelizer decimates, so start and end are in its samples
+            for (unsigned i = 0; i < threads; i++) {
+                sources.push_back(std::make_shared<Channelizer>(input, channels)->channel(channel));
+            }
+            start /= channels;
+            end /= channels;
+        } else {
+            const double offset = parse(offsetOption, "offset");
+            const double bandwidth = parse(bandwidthOption, "bandwidth");
+            if (bandwidth <= 0 || bandwidth > rate)
+                throw std::runtime_error("Bandwidth must be between 0 and the sample rate");
+            if (std::abs(offset) > rate / 2)
+                throw std::runtime_error("Offset is outside the recording");
+
+            decimation = std::max((int)(rate / bandwidth), 1);
+            if (parser.isSet(decimationOption))
+                decimation = std::max((int)parse(decimationOption, "decimation"), 1);
+
+            // Same filter design as the GUI tuner, but with unity gain
+            const float cutoff = bandwidth / 2 / rate;
+            const float atten = 60.0f;
+            auto len = estimate_req_filter_len(std::min(cutoff, 0.05f), atten);
+            std::vector<float> taps(len);
+            liquid_firdes_kaiser(len, cutoff, atten, 0.0f, taps.data());
+            const float sum = std::accumulate(taps.begin(), taps.end(), 0.0f);
+            for (auto &tap : taps) {
+                tap /= sum;
+            }
+
+            for (unsigned i = 0; i < threads; i++) {
+                auto tuner = std::make_shared<TunerTransform>(input);
+                tuner->setTuning(offset / rate * Tau, taps, bandwidth / rate);
+                sources.push_back(tuner);
+            }
+        }
+        if (start >= end)
+            throw std::runtime_error("Nothing to extract");
+
+        SampleExporter<std::complex<float>> exporter(sources, outputFilename.toStdString(), start, end, decimation);
+        exporter.setFormat(format, parse(scaleOption, "scale"), parser.isSet(ditherOption));
+        exporter.writeMetaData();
+        exporter.start();
+        while (!exporter.finished()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (!exporter.error().empty())
+            throw std::runtime_error(exporter.error());
+    } catch (const std::exception &e) {
+        fprintf(stderr, "ERROR: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
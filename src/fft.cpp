@@ -19,6 +19,10 @@
 
 #include "fft.h"
 #include "string.h"
+#include <mutex>
+
+// Only fftw_execute is thread-safe, so serialise planning
+static std::mutex plannerMutex;
 
 FFT::FFT(int size)
 {
@@ -26,11 +30,13 @@ FFT::FFT(int size)
 
     fftwIn = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
     fftwOut = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
+    std::lock_guard<std::mutex> lock(plannerMutex);
     fftwPlan = fftwf_plan_dft_1d(fftSize, fftwIn, fftwOut, FFTW_FORWARD, FFTW_MEASURE);
 }
 
 FFT::~FFT()
 {
+    std::lock_guard<std::mutex> lock(plannerMutex);
     if (fftwPlan) fftwf_destroy_plan(fftwPlan);
     if (fftwIn) fftwf_free(fftwIn);
     if (fftwOut) fftwf_free(fftwOut);
@@ -0,0 +1,153 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <string.h>
+#include "filereader.h"
+
+// Part of another reader's block, which it keeps alive, with offsets
+// from somewhere else
+struct Slice : FileReader::Block
+{
+    Slice(std::shared_ptr<const Block> parent, const uchar *data, size_t offset, size_t length)
+        : Block(data, offset, length), parent(std::move(parent)) { };
+
+    std::shared_ptr<const Block> parent;
+};
+
+bool FileReader::read(size_t offset, size_t length, uchar *dest)
+{
+    while (length > 0) {
+        auto b = block(offset);
+        if (b == nullptr)
+            return false;
+
+        size_t n = std::min(length, b->offset + b->length - offset);
+        memcpy(dest, b->data + (offset - b->offset), n);
+        dest += n;
+        offset += n;
+        length -= n;
+    }
+    return true;
+}
+
+std::shared_ptr<const FileReader::Block> FileRegion::block(size_t offset)
+{
+    if (offset >= length)
+        return nullptr;
+
+    auto b = reader->block(this->offset + offset);
+    if (b == nullptr)
+        return nullptr;
+
+    // Clip it to the region, and give it offsets from the region's start
+    size_t start = std::max(b->offset, this->offset);
+    size_t end = std::min(b->offset + b->length, this->offset + length);
+    auto data = b->data + (start - b->offset);
+    return std::make_shared<Slice>(std::move(b), data, start - this->offset, end - start);
+}
+
+void FileRegion::prefetch(size_t offset, size_t length)
+{
+    if (offset >= this->length)
+        return;
+    reader->prefetch(this->offset + offset, std::min(length, this->length - offset));
+}
+
+void FileRegion::setPreload(bool enabled)
+{
+    // Only the region, not the whole file
+    if (enabled)
+        prefetch(0, length);
+}
+
+void ConcatenatedFile::append(std::unique_ptr<FileReader> reader)
+{
+    size_t start = size();
+    segments.push_back({start, std::move(reader)});
+}
+
+size_t ConcatenatedFile::size()
+{
+    if (segments.empty())
+        return 0;
+    return segments.back().start + segments.back().reader->size();
+}
+
+void ConcatenatedFile::resize(size_t size)
+{
+    if (segments.empty() || size < segments.back().start)
+        return;
+    segments.back().reader->resize(size - segments.back().start);
+}
+
+bool ConcatenatedFile::resizable()
+{
+    return !segments.empty() && segments.back().reader->resizable();
+}
+
+size_t ConcatenatedFile::find(size_t offset)
+{
+    // Empty segments start where the next one does, so take the last
+    // segment starting at or before offset
+    auto it = std::upper_bound(segments.begin(), segments.end(), offset, [](size_t offset, const Segment &segment) {
+        return offset < segment.start;
+    });
+    return it - segments.begin() - 1;
+}
+
+std::shared_ptr<const FileReader::Block> ConcatenatedFile::block(size_t offset)
+{
+    if (offset >= size())
+        return nullptr;
+
+    auto &segment = segments[find(offset)];
+    auto b = segment.reader->block(offset - segment.start);
+    if (b == nullptr)
+        return nullptr;
+
+    // Blocks stop at the end of their segment, so a sample split between
+    // two files is put back together by the caller
+    auto data = b->data;
+    auto length = b->length;
+    size_t start = segment.start + b->offset;
+    return std::make_shared<Slice>(std::move(b), data, start, length);
+}
+
+void ConcatenatedFile::prefetch(size_t offset, size_t length)
+{
+    size_t end = std::min(offset + length, size());
+    if (offset >= end)
+        return;
+
+    for (size_t i = find(offset); i < segments.size() && segments[i].start < end; i++) {
+        auto &segment = segments[i];
+        size_t start = std::max(offset, segment.start);
+        size_t stop = std::min(end, segment.start + segment.reader->size());
+        if (start < stop)
+            segment.reader->prefetch(start - segment.start, stop - start);
+    }
+}
+
+void ConcatenatedFile::setPreload(bool enabled)
+{
+    for (auto &segment : segments) {
+        segment.reader->setPreload(enabled);
+    }
+}
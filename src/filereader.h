@@ -0,0 +1,124 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+
+/*
+ * Random access to the bytes of a capture, a block at a time. Readers
+ * that can cheaply do so also put the first few bytes of the next block
+ * at the end of each block, so a read of one sample rarely straddles
+ * two blocks.
+ *
+ * All methods can be called from any thread. A block stays valid for as
+ * long as a reader holds on to it, even if it has since been evicted.
+ */
+class FileReader
+{
+public:
+    struct Block
+    {
+        Block(const uchar *data, size_t offset, size_t length)
+            : data(data), offset(offset), length(length) { };
+
+        const uchar *data;
+        // Bytes [offset, offset + length) of the file
+        size_t offset;
+        size_t length;
+    };
+
+    virtual ~FileReader() { };
+
+    virtual size_t size() = 0;
+    // Follow the file growing (or shrinking) to size bytes. Blocks that
+    // ended at the old end of the file are read again when next used.
+    virtual void resize(size_t size) = 0;
+    // Whether resize() can follow the file, which it can't when the
+    // file's size isn't the size of the data, e.g. when it's compressed
+    virtual bool resizable() { return true; };
+    // The block holding offset, or nullptr if offset is past the end of
+    // the file or it couldn't be read
+    virtual std::shared_ptr<const Block> block(size_t offset) = 0;
+    // Start reading [offset, offset + length) in the background, so
+    // reading it later doesn't have to wait
+    virtual void prefetch(size_t offset, size_t length) { };
+    // For files that fit in memory: read as much of the file ahead as
+    // the reader can hold
+    virtual void setPreload(bool enabled) { };
+
+    // Copy [offset, offset + length) into dest, from however many blocks
+    // it spans
+    bool read(size_t offset, size_t length, uchar *dest);
+};
+
+/*
+ * A region of the file another reader reads, e.g. one member of an
+ * uncompressed tar archive, read in place.
+ */
+class FileRegion : public FileReader
+{
+public:
+    FileRegion(std::shared_ptr<FileReader> reader, size_t offset, size_t length)
+        : reader(std::move(reader)), offset(offset), length(length) { };
+
+    size_t size() override { return length; };
+    void resize(size_t size) override { };
+    bool resizable() override { return false; };
+    std::shared_ptr<const Block> block(size_t offset) override;
+    void prefetch(size_t offset, size_t length) override;
+    void setPreload(bool enabled) override;
+
+private:
+    std::shared_ptr<FileReader> reader;
+    size_t offset;
+    size_t length;
+};
+
+/*
+ * Files read one after another as if they were one, e.g. a recording
+ * split into numbered chunks. Only the last one can grow.
+ */
+class ConcatenatedFile : public FileReader
+{
+public:
+    // Add reader after the end of the last one, at its current size
+    void append(std::unique_ptr<FileReader> reader);
+
+    size_t size() override;
+    void resize(size_t size) override;
+    bool resizable() override;
+    std::shared_ptr<const Block> block(size_t offset) override;
+    void prefetch(size_t offset, size_t length) override;
+    void setPreload(bool enabled) override;
+
+private:
+    struct Segment
+    {
+        size_t start;
+        std::unique_ptr<FileReader> reader;
+    };
+
+    // The segment offset is in
+    size_t find(size_t offset);
+
+    std::vector<Segment> segments;
+};
@@ -18,7 +18,7 @@
  */
 
 #include "frequencydemod.h"
-#include <liquid/liquid.h>
+#include "kernels.h"
 #include "util.h"
 
 FrequencyDemod::FrequencyDemod(std::shared_ptr<SampleSource<std::complex<float>>> src) : SampleBuffer(src)
@@ -30,9 +30,25 @@ void FrequencyDemod::work(void *input, void *output, int count, size_t sampleid)
 {
     auto in = static_cast<std::complex<float>*>(input);
     auto out = static_cast<float*>(output);
-    freqdem fdem = freqdem_create(relativeBandwidth() / 2.0);
-    for (int i = 0; i < count; i++) {
-        freqdem_demodulate(fdem, in[i], &out[i]);
-    }
-    freqdem_destroy(fdem);
+    // Same scaling as liquid's freqdem with kf = relativeBandwidth() / 2
+    float gain = 1.0f / (M_PI * relativeBandwidth());
+    kernels::fmDemod(in, out, count, current->previous, gain);
+    if (count > 0)
+        current->previous = in[count - 1];
+}
+
+std::unique_ptr<AbstractSampleBuffer::State> FrequencyDemod::createState()
+{
+    return std::make_unique<DemodState>();
+}
+
+void FrequencyDemod::useState(State *state)
+{
+    current = state != nullptr ? static_cast<DemodState*>(state) : &own;
+}
+
+size_t FrequencyDemod::historyLength()
+{
+    // Only the previous sample is carried over
+    return 1;
 }
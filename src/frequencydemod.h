@@ -23,6 +23,20 @@
 
 class FrequencyDemod : public SampleBuffer<std::complex<float>, float>
 {
+private:
+    struct DemodState : State
+    {
+        std::complex<float> previous = 0;
+    };
+    // The state used by direct work() calls, and the one work() uses now
+    DemodState own;
+    DemodState *current = &own;
+
+protected:
+    std::unique_ptr<State> createState() override;
+    void useState(State *state) override;
+    size_t historyLength() override;
+
 public:
     FrequencyDemod(std::shared_ptr<SampleSource<std::complex<float>>> src);
     void work(void *input, void *output, int count, size_t sampleid) override;
@@ -0,0 +1,70 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputchannel.h"
+
+InputChannel::InputChannel(InputSource *input, int channel) : input(input), channel(channel)
+{
+    input->subscribe(this);
+}
+
+InputChannel::~InputChannel()
+{
+    input->unsubscribe(this);
+}
+
+void InputChannel::invalidateEvent(const Invalidation &invalidation)
+{
+    invalidate(invalidation);
+}
+
+std::unique_ptr<std::complex<float>[]> InputChannel::getSamples(size_t start, size_t length)
+{
+    return input->getSamples(channel, start, length);
+}
+
+size_t InputChannel::count()
+{
+    return input->count();
+}
+
+double InputChannel::rate()
+{
+    return input->rate();
+}
+
+float InputChannel::relativeBandwidth()
+{
+    return input->relativeBandwidth();
+}
+
+bool InputChannel::realSignal()
+{
+    return input->realSignal();
+}
+
+double InputChannel::getFrequency()
+{
+    return input->getFrequency();
+}
+
+double InputChannel::captureFrequency(size_t sample)
+{
+    return input->captureFrequency(sample);
+}
@@ -0,0 +1,47 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <complex>
+#include "inputsource.h"
+
+/*
+ * One channel of a recording with several channels interleaved sample by
+ * sample, as a source of its own. Channel 0 is the InputSource itself.
+ */
+class InputChannel : public SampleSource<std::complex<float>>, public Subscriber
+{
+public:
+    InputChannel(InputSource *input, int channel);
+    ~InputChannel();
+
+    void invalidateEvent(const Invalidation &invalidation) override;
+    std::unique_ptr<std::complex<float>[]> getSamples(size_t start, size_t length) override;
+    size_t count() override;
+    double rate() override;
+    float relativeBandwidth() override;
+    bool realSignal() override;
+    double getFrequency() override;
+    double captureFrequency(size_t sample) override;
+
+private:
+    InputSource *input;
+    int channel;
+};
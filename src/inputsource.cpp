@@ -19,6 +19,11 @@
  */
 
 #include "inputsource.h"
+#include "bufferedfile.h"
+#include "compressedfile.h"
+#include "mappedfile.h"
+#include "perfstats.h"
+#include "tracing.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -26,199 +31,17 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <vector>
 
 #include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
 
-#include <QElapsedTimer>
-#include <QPainter>
-#include <QPaintEvent>
-#include <QPixmapCache>
-#include <QRect>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
 
-
-class ComplexF32SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(std::complex<float>);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const std::complex<float>*>(src);
-        std::copy(&s[start], &s[start + length], dest);
-    }
-};
-
-class ComplexF64SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(std::complex<double>);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const std::complex<double>*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const std::complex<double>& v) -> std::complex<float> {
-                return { static_cast<float>(v.real()) , static_cast<float>(v.imag()) };
-            }
-        );
-    }
-};
-
-class ComplexS32SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(std::complex<int32_t>);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const std::complex<int32_t>*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const std::complex<int32_t>& v) -> std::complex<float> {
-                const float k = 1.0f / 2147483648.0f;
-                return { v.real() * k, v.imag() * k };
-            }
-        );
-    }
-};
-
-class ComplexS16SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(std::complex<int16_t>);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const std::complex<int16_t>*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const std::complex<int16_t>& v) -> std::complex<float> {
-                const float k = 1.0f / 32768.0f;
-                return { v.real() * k, v.imag() * k };
-            }
-        );
-    }
-};
-
-class ComplexS8SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(std::complex<int8_t>);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const std::complex<int8_t>*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const std::complex<int8_t>& v) -> std::complex<float> {
-                const float k = 1.0f / 128.0f;
-                return { v.real() * k, v.imag() * k };
-            }
-        );
-    }
-};
-
-class ComplexU8SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(std::complex<uint8_t>);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const std::complex<uint8_t>*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const std::complex<uint8_t>& v) -> std::complex<float> {
-                const float k = 1.0f / 128.0f;
-                return { (v.real() - 127.4f) * k, (v.imag() - 127.4f) * k };
-            }
-        );
-    }
-};
-
-class RealF32SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(float);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const float*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const float& v) -> std::complex<float> {
-                return {v, 0.0f};
-            }
-        );
-    }
-};
-
-class RealF64SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(double);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const double*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const double& v) -> std::complex<float> {
-                return {static_cast<float>(v), 0.0f};
-            }
-        );
-    }
-};
-
-class RealS16SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(int16_t);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const int16_t*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const int16_t& v) -> std::complex<float> {
-                const float k = 1.0f / 32768.0f;
-                return { v * k, 0.0f };
-            }
-        );
-    }
-};
-
-class RealS8SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(int8_t);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const int8_t*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const int8_t& v) -> std::complex<float> {
-                const float k = 1.0f / 128.0f;
-                return { v * k, 0.0f };
-            }
-        );
-    }
-};
-
-class RealU8SampleAdapter : public SampleAdapter {
-public:
-    size_t sampleSize() override {
-        return sizeof(uint8_t);
-    }
-
-    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
-        auto s = reinterpret_cast<const uint8_t*>(src);
-        std::transform(&s[start], &s[start + length], dest,
-            [](const uint8_t& v) -> std::complex<float> {
-                const float k = 1.0f / 128.0f;
-                return { (v - 127.4f) * k, 0 };
-            }
-        );
-    }
-};
-
 InputSource::InputSource()
 {
 }
@@ -230,26 +53,141 @@ InputSource::~InputSource()
 
 void InputSource::cleanup()
 {
-    if (mmapData != nullptr) {
-        inputFile->unmap(mmapData);
-        mmapData = nullptr;
-    }
+    reader.reset();
+    inputFiles.clear();
+    nextChunk.clear();
+    channelAdapters.clear();
+}
 
-    if (inputFile != nullptr) {
-        delete inputFile;
-        inputFile = nullptr;
+struct TarMember
+{
+    QString name;
+    size_t offset;
+    size_t size;
+};
+
+static size_t parseTarNumber(const char *field, size_t length)
+{
+    // GNU tar stores numbers too big for octal (files over 8 GiB) in
+    // base-256, flagged by the top bit
+    size_t value = 0;
+    if (field[0] & 0x80) {
+        value = field[0] & 0x7f;
+        for (size_t i = 1; i < length; i++)
+            value = (value << 8) | (uchar)field[i];
+        return value;
+    }
+    for (size_t i = 0; i < length && field[i] != '\0'; i++) {
+        if (field[i] >= '0' && field[i] <= '7')
+            value = (value << 3) | (field[i] - '0');
+    }
+    return value;
+}
+
+// List the regular files in a tar archive, and where their contents are,
+// from the headers alone
+static std::vector<TarMember> readTarIndex(QFile &file)
+{
+    std::vector<TarMember> members;
+    QString longName;
+    size_t longSize = 0;
+    size_t offset = 0;
+    char header[512];
+
+    while (true) {
+        if (!file.seek(offset) || file.read(header, sizeof(header)) != sizeof(header))
+            throw std::runtime_error("SigMF archive is truncated");
+        if (header[0] == '\0')
+            break;
+
+        // The checksum is calculated with its own field as spaces
+        size_t checksum = 0;
+        for (size_t i = 0; i < sizeof(header); i++)
+            checksum += (i >= 148 && i < 156) ? ' ' : (uchar)header[i];
+        if (checksum != parseTarNumber(&header[148], 8))
+            throw std::runtime_error("SigMF archive is not a valid tar file");
+
+        size_t size = parseTarNumber(&header[124], 12);
+        size_t data = offset + sizeof(header);
+        char type = header[156];
+
+        if (type == 'L' || type == 'x') {
+            // GNU long name, or pax extended header, for the next member
+            QByteArray contents(size, '\0');
+            if (!file.seek(data) || file.read(contents.data(), size) != (qint64)size)
+                throw std::runtime_error("SigMF archive is truncated");
+            if (type == 'L') {
+                longName = QString::fromUtf8(contents.constData());
+            } else {
+                // Records are "<length> <key>=<value>\n"
+                for (int pos = 0; pos < contents.size();) {
+                    int space = contents.indexOf(' ', pos);
+                    int length = contents.mid(pos, space - pos).toInt();
+                    if (space < 0 || length <= 0)
+                        break;
+                    auto record = contents.mid(space + 1, pos + length - space - 2);
+                    int equals = record.indexOf('=');
+                    auto key = record.left(equals);
+                    auto value = record.mid(equals + 1);
+                    if (key == "path")
+                        longName = QString::fromUtf8(value);
+                    else if (key == "size")
+                        longSize = value.toULongLong();
+                    pos += length;
+                }
+            }
+        } else {
+            if (longSize > 0)
+                size = longSize;
+            if (type == '0' || type == '\0') {
+                QString name = longName;
+                if (name.isEmpty()) {
+                    name = QString::fromUtf8(header, strnlen(header, 100));
+                    // ustar splits long names into a prefix and a name
+                    if (memcmp(&header[257], "ustar", 5) == 0 && header[345] != '\0')
+                        name = QString::fromUtf8(&header[345], strnlen(&header[345], 155)) + "/" + name;
+                }
+                members.push_back({name, data, size});
+            }
+            longName.clear();
+            longSize = 0;
+        }
+        offset = data + (size + sizeof(header) - 1) / sizeof(header) * sizeof(header);
     }
+    return members;
+}
+
+// Recorders split long captures into numbered chunks, e.g. cap_000.cs16,
+// cap_001.cs16. Returns the name of the chunk after filename, or an empty
+// string if it isn't numbered.
+static QString chunkAfter(const QString &filename)
+{
+    static const QRegularExpression numbered("^(.*[^A-Za-z0-9])?(\\d+)(\\..*)$");
+    QFileInfo fileInfo(filename);
+    auto match = numbered.match(fileInfo.fileName());
+    if (!match.hasMatch())
+        return QString();
+
+    auto number = match.captured(2);
+    auto next = QString("%1").arg(number.toULongLong() + 1, number.size(), 10, QChar('0'));
+    return fileInfo.path() + "/" + match.captured(1) + next + match.captured(3);
 }
 
-QJsonObject InputSource::readMetaData(const QString &filename)
+QJsonObject InputSource::readMetaData(const QString &filename, Recording &recording)
 {
     QFile datafile(filename);
     if (!datafile.open(QFile::ReadOnly | QIODevice::Text)) {
         throw std::runtime_error("Error while opening meta data file: " + datafile.errorString().toStdString());
     }
 
-    QJsonDocument d = QJsonDocument::fromJson(datafile.readAll());
+    auto root = parseMetaData(datafile.readAll(), recording);
     datafile.close();
+    return root;
+}
+
+QJsonObject InputSource::parseMetaData(const QByteArray &json, Recording &recording)
+{
+    QJsonDocument d = QJsonDocument::fromJson(json);
     auto root = d.object();
 
     if (!root.contains("global") || !root["global"].isObject()) {
@@ -265,49 +203,98 @@ QJsonObject InputSource::readMetaData(const QString &filename)
 
     auto datatype = global["core:datatype"].toString();
     if (datatype.compare("cf32_le") == 0) {
-        sampleAdapter = std::make_unique<ComplexF32SampleAdapter>();
+        recording.format = std::make_unique<ComplexF32SampleAdapter>();
+    } else if (datatype.compare("cf32_be") == 0) {
+        recording.format = std::make_unique<ComplexF32BESampleAdapter>();
+    } else if (datatype.compare("cf64_le") == 0) {
+        recording.format = std::make_unique<ComplexF64SampleAdapter>();
+    } else if (datatype.compare("cf64_be") == 0) {
+        recording.format = std::make_unique<ComplexF64BESampleAdapter>();
     } else if (datatype.compare("ci32_le") == 0) {
-        sampleAdapter = std::make_unique<ComplexS32SampleAdapter>();
+        recording.format = std::make_unique<ComplexS32SampleAdapter>();
+    } else if (datatype.compare("ci32_be") == 0) {
+        recording.format = std::make_unique<ComplexS32BESampleAdapter>();
     } else if (datatype.compare("ci16_le") == 0) {
-        sampleAdapter = std::make_unique<ComplexS16SampleAdapter>();
+        recording.format = std::make_unique<ComplexS16SampleAdapter>();
+    } else if (datatype.compare("ci16_be") == 0) {
+        recording.format = std::make_unique<ComplexS16BESampleAdapter>();
     } else if (datatype.compare("ci8") == 0) {
-        sampleAdapter = std::make_unique<ComplexS8SampleAdapter>();
+        recording.format = std::make_unique<ComplexS8SampleAdapter>();
+    } else if (datatype.compare("ci12_le") == 0) {
+        recording.format = std::make_unique<ComplexS12SampleAdapter>();
+    } else if (datatype.compare("ci4") == 0) {
+        recording.format = std::make_unique<ComplexS4SampleAdapter>();
     } else if (datatype.compare("cu8") == 0) {
-        sampleAdapter = std::make_unique<ComplexU8SampleAdapter>();
+        recording.format = std::make_unique<ComplexU8SampleAdapter>();
     } else if (datatype.compare("rf32_le") == 0) {
-        sampleAdapter = std::make_unique<RealF32SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealF32SampleAdapter>();
+        recording.realSignal = true;
+    } else if (datatype.compare("rf32_be") == 0) {
+        recording.format = std::make_unique<RealF32BESampleAdapter>();
+        recording.realSignal = true;
+    } else if (datatype.compare("rf64_le") == 0) {
+        recording.format = std::make_unique<RealF64SampleAdapter>();
+        recording.realSignal = true;
+    } else if (datatype.compare("rf64_be") == 0) {
+        recording.format = std::make_unique<RealF64BESampleAdapter>();
+        recording.realSignal = true;
     } else if (datatype.compare("ri16_le") == 0) {
-        sampleAdapter = std::make_unique<RealS16SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealS16SampleAdapter>();
+        recording.realSignal = true;
+    } else if (datatype.compare("ri16_be") == 0) {
+        recording.format = std::make_unique<RealS16BESampleAdapter>();
+        recording.realSignal = true;
     } else if (datatype.compare("ri8") == 0) {
-        sampleAdapter = std::make_unique<RealS8SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealS8SampleAdapter>();
+        recording.realSignal = true;
+    } else if (datatype.compare("ri12_le") == 0) {
+        recording.format = std::make_unique<RealS12SampleAdapter>();
+        recording.realSignal = true;
+    } else if (datatype.compare("ri4") == 0) {
+        recording.format = std::make_unique<RealS4SampleAdapter>();
+        recording.realSignal = true;
     } else if (datatype.compare("ru8") == 0) {
-        sampleAdapter = std::make_unique<RealU8SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealU8SampleAdapter>();
+        recording.realSignal = true;
     } else {
         throw std::runtime_error("SigMF meta data specifies unsupported datatype");
     }
 
     if (global.contains("core:sample_rate") && global["core:sample_rate"].isDouble()) {
-        setSampleRate(global["core:sample_rate"].toDouble());
+        recording.sampleRate = global["core:sample_rate"].toDouble();
+    }
+
+    if (global.contains("core:num_channels") && global["core:num_channels"].isDouble()) {
+        recording.channels = global["core:num_channels"].toInt();
+        if (recording.channels < 1)
+            throw std::runtime_error("SigMF meta data is invalid (num_channels must be at least 1)");
     }
 
 
     if (root.contains("captures") && root["captures"].isArray()) {
-        auto captures = root["captures"].toArray();
+        auto capturesArray = root["captures"].toArray();
 
-        for (auto capture_ref : captures) {
+        for (auto capture_ref : capturesArray) {
             if (capture_ref.isObject()) {
                 auto capture = capture_ref.toObject();
+                // Captures without a frequency keep the one before
+                double captureFrequency = recording.captures.empty() ? 0 : recording.captures.back().frequency;
                 if (capture.contains("core:frequency") && capture["core:frequency"].isDouble()) {
-                    frequency = capture["core:frequency"].toDouble();
+                    captureFrequency = capture["core:frequency"].toDouble();
                 }
+                const size_t sample_start = capture["core:sample_start"].toDouble();
+                if (!recording.captures.empty() && sample_start < recording.captures.back().sample) {
+                    throw std::runtime_error("SigMF meta data is invalid (captures out of order)");
+                }
+                const size_t header_bytes = capture["core:header_bytes"].toDouble();
+                recording.captures.push_back({sample_start, captureFrequency, header_bytes});
             } else {
                 throw std::runtime_error("SigMF meta data is invalid (invalid capture object)");
             }
         }
+        if (!recording.captures.empty()) {
+            recording.frequency = recording.captures.front().frequency;
+        }
     }
 
     if(root.contains("annotations") && root["annotations"].isArray()) {
@@ -345,7 +332,7 @@ QJsonObject InputSource::readMetaData(const QString &filename)
 
                 auto comment = sigmf_annotation["core:comment"].toString();
 
-                annotationList.emplace_back(sampleRange, frequencyRange, label, comment);
+                recording.annotations.emplace_back(sampleRange, frequencyRange, label, comment);
             }
         }
     }
@@ -353,62 +340,152 @@ QJsonObject InputSource::readMetaData(const QString &filename)
     return root;
 }
 
+std::unique_ptr<FileReader> InputSource::openReader(QFile *file, const std::string &compression, size_t overlap)
+{
+    // Read the start of the file now, so failures are reported when the
+    // file is opened rather than as missing samples later. An empty file
+    // may be a recording that's about to start, so is allowed.
+    auto size = file->size();
+    std::unique_ptr<FileReader> newReader;
+    if (!compression.empty())
+        newReader = openCompressedFile(file, compression);
+    if (newReader == nullptr && !bufferedReads) {
+        newReader = std::make_unique<MappedFile>(file, overlap);
+        // Some FUSE and network filesystems can't be mapped
+        if (size > 0 && newReader->block(0) == nullptr)
+            newReader.reset();
+    }
+    if (newReader == nullptr) {
+        newReader = std::make_unique<BufferedFile>(file, overlap);
+        if (size > 0 && newReader->block(0) == nullptr)
+            throw std::runtime_error("Error reading file");
+    }
+    return newReader;
+}
+
 void InputSource::openFile(const char *filename)
 {
     QFileInfo fileInfo(filename);
+
+    // Compressed captures are named for the format they hold, e.g.
+    // capture.cs16.zst, so look past the compression suffix
+    std::string compression;
+    auto outerSuffix = fileInfo.suffix().toLower();
+    if (outerSuffix == "gz" || outerSuffix == "zst") {
+        compression = outerSuffix.toStdString();
+        fileInfo = QFileInfo(fileInfo.path() + "/" + fileInfo.completeBaseName());
+    }
+
+    // Nothing is changed until the file is open, so a failure leaves the
+    // old recording as it was
+    Recording recording;
+    recording.channels = _channels;
+    recording.sampleRate = sampleRate;
+    recording.frequency = frequency;
     std::string suffix = std::string(fileInfo.suffix().toLower().toUtf8().constData());
     if (_fmt != "") { suffix = _fmt; } // allow fmt override
     if ((suffix == "cfile") || (suffix == "cf32")  || (suffix == "fc32")) {
-        sampleAdapter = std::make_unique<ComplexF32SampleAdapter>();
+        recording.format = std::make_unique<ComplexF32SampleAdapter>();
+    }
+    else if ((suffix == "cf32_be") || (suffix == "fc32_be")) {
+        recording.format = std::make_unique<ComplexF32BESampleAdapter>();
     }
     else if ((suffix == "cf64")  || (suffix == "fc64")) {
-        sampleAdapter = std::make_unique<ComplexF64SampleAdapter>();
+        recording.format = std::make_unique<ComplexF64SampleAdapter>();
+    }
+    else if ((suffix == "cf64_be") || (suffix == "fc64_be")) {
+        recording.format = std::make_unique<ComplexF64BESampleAdapter>();
     }
     else if ((suffix == "cs32") || (suffix == "sc32") || (suffix == "c32")) {
-        sampleAdapter = std::make_unique<ComplexS32SampleAdapter>();
+        recording.format = std::make_unique<ComplexS32SampleAdapter>();
+    }
+    else if ((suffix == "cs32_be") || (suffix == "sc32_be") || (suffix == "c32_be")) {
+        recording.format = std::make_unique<ComplexS32BESampleAdapter>();
     }
     else if ((suffix == "cs16") || (suffix == "sc16") || (suffix == "c16")) {
-        sampleAdapter = std::make_unique<ComplexS16SampleAdapter>();
+        recording.format = std::make_unique<ComplexS16SampleAdapter>();
+    }
+    else if ((suffix == "cs16_be") || (suffix == "sc16_be") || (suffix == "c16_be")) {
+        recording.format = std::make_unique<ComplexS16BESampleAdapter>();
     }
     else if ((suffix == "cs8") || (suffix == "sc8") || (suffix == "c8")) {
-        sampleAdapter = std::make_unique<ComplexS8SampleAdapter>();
+        recording.format = std::make_unique<ComplexS8SampleAdapter>();
+    }
+    else if ((suffix == "cs12") || (suffix == "sc12") || (suffix == "ci12")) {
+        recording.format = std::make_unique<ComplexS12SampleAdapter>();
+    }
+    else if ((suffix == "cs4") || (suffix == "sc4") || (suffix == "ci4")) {
+        recording.format = std::make_unique<ComplexS4SampleAdapter>();
     }
     else if ((suffix == "cu8") || (suffix == "uc8")) {
-        sampleAdapter = std::make_unique<ComplexU8SampleAdapter>();
+        recording.format = std::make_unique<ComplexU8SampleAdapter>();
     }
     else if (suffix == "f32") {
-        sampleAdapter = std::make_unique<RealF32SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealF32SampleAdapter>();
+        recording.realSignal = true;
+    }
+    else if (suffix == "f32_be") {
+        recording.format = std::make_unique<RealF32BESampleAdapter>();
+        recording.realSignal = true;
     }
     else if (suffix == "f64") {
-        sampleAdapter = std::make_unique<RealF64SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealF64SampleAdapter>();
+        recording.realSignal = true;
+    }
+    else if (suffix == "f64_be") {
+        recording.format = std::make_unique<RealF64BESampleAdapter>();
+        recording.realSignal = true;
     }
     else if (suffix == "s16") {
-        sampleAdapter = std::make_unique<RealS16SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealS16SampleAdapter>();
+        recording.realSignal = true;
+    }
+    else if (suffix == "s16_be") {
+        recording.format = std::make_unique<RealS16BESampleAdapter>();
+        recording.realSignal = true;
     }
     else if (suffix == "s8") {
-        sampleAdapter = std::make_unique<RealS8SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealS8SampleAdapter>();
+        recording.realSignal = true;
+    }
+    else if (suffix == "s12") {
+        recording.format = std::make_unique<RealS12SampleAdapter>();
+        recording.realSignal = true;
+    }
+    else if (suffix == "s4") {
+        recording.format = std::make_unique<RealS4SampleAdapter>();
+        recording.realSignal = true;
     }
     else if (suffix == "u8") {
-        sampleAdapter = std::make_unique<RealU8SampleAdapter>();
-        _realSignal = true;
+        recording.format = std::make_unique<RealU8SampleAdapter>();
+        recording.realSignal = true;
     }
     else {
-        sampleAdapter = std::make_unique<ComplexF32SampleAdapter>();
+        recording.format = std::make_unique<ComplexF32SampleAdapter>();
     }
 
     QString dataFilename;
+    // Where the recording is in dataFilename, if it's part of an archive
+    range_t<size_t> archiveMember{0, 0};
 
-    annotationList.clear();
     QString metaFilename;
 
     if (suffix == "sigmf-meta" || suffix == "sigmf-data" || suffix == "sigmf-") {
         dataFilename = fileInfo.path() + "/" + fileInfo.completeBaseName() + ".sigmf-data";
         metaFilename = fileInfo.path() + "/" + fileInfo.completeBaseName() + ".sigmf-meta";
-        auto metaData = readMetaData(metaFilename);
+        auto metaData = readMetaData(metaFilename, recording);
+        if (!compression.empty()) {
+            dataFilename = filename;
+        } else if (!QFile::exists(dataFilename)) {
+            // The recording may have been compressed on its own
+            for (auto c : {"zst", "gz"}) {
+                if (QFile::exists(dataFilename + "." + c)) {
+                    dataFilename += QString(".") + c;
+                    compression = c;
+                    break;
+                }
+            }
+        }
         QFile datafile(dataFilename);
         if (!datafile.open(QFile::ReadOnly | QIODevice::Text)) {
             auto global = metaData["global"].toObject();
@@ -424,36 +501,224 @@ void InputSource::openFile(const char *filename)
         }
     }
     else if (suffix == "sigmf") {
-        throw std::runtime_error("SigMF archives are not supported. Consider extracting a recording.");
+        if (!compression.empty())
+            throw std::runtime_error("Compressed SigMF archives are not supported. Consider extracting a recording.");
+
+        // Archives are uncompressed tar files, so the recording can be
+        // read where it is in the archive
+        QFile archive(filename);
+        if (!archive.open(QFile::ReadOnly)) {
+            throw std::runtime_error(archive.errorString().toStdString());
+        }
+        auto members = readTarIndex(archive);
+        auto meta = std::find_if(members.begin(), members.end(), [](const TarMember &m) {
+            return m.name.endsWith(".sigmf-meta");
+        });
+        if (meta == members.end())
+            throw std::runtime_error("SigMF archive does not contain a recording");
+        auto dataName = meta->name.left(meta->name.size() - 5) + "data";
+        auto data = std::find_if(members.begin(), members.end(), [&](const TarMember &m) {
+            return m.name == dataName;
+        });
+        if (data == members.end())
+            throw std::runtime_error("SigMF archive does not contain the data for " + meta->name.toStdString());
+
+        archive.seek(meta->offset);
+        parseMetaData(archive.read(meta->size), recording);
+        dataFilename = filename;
+        archiveMember = {data->offset, data->offset + data->size};
     }
     else {
         dataFilename = filename;
     }
 
-    auto file = std::make_unique<QFile>(dataFilename);
-    if (!file->open(QFile::ReadOnly)) {
-        throw std::runtime_error(file->errorString().toStdString());
+    // Each channel reads its samples out of whole frames, so everything
+    // below works in frames
+    std::vector<std::shared_ptr<SampleAdapter>> adapters;
+    auto &format = recording.format;
+    const int channels = recording.channels;
+    if (channels > 1) {
+        if (format->samplesPerPack() != 1)
+            throw std::runtime_error("Interleaved channels of packed real samples are not supported");
+        for (int channel = 0; channel < channels; channel++) {
+            adapters.push_back(std::make_shared<InterleavedSampleAdapter>(format, channels, channel));
+        }
+    } else {
+        adapters.push_back(format);
     }
+    auto frames = adapters[0];
 
-    auto size = file->size();
-    sampleCount = size / sampleAdapter->sampleSize();
+    std::vector<std::unique_ptr<QFile>> files;
+    auto openData = [&](const QString &name) {
+        auto file = std::make_unique<QFile>(name);
+        if (!file->open(QFile::ReadOnly)) {
+            throw std::runtime_error(file->errorString().toStdString());
+        }
+        auto fileReader = openReader(file.get(), compression, frames->sampleSize());
+        files.push_back(std::move(file));
+        return fileReader;
+    };
+    auto newReader = openData(dataFilename);
+
+    if (archiveMember.maximum > 0) {
+        if (archiveMember.maximum > newReader->size())
+            throw std::runtime_error("SigMF archive is truncated");
+        newReader = std::make_unique<FileRegion>(std::move(newReader), archiveMember.minimum, archiveMember.length());
+    }
+
+    // Non-conforming datasets have a header before each capture's samples,
+    // so the captures are read from between them
+    auto &captures = recording.captures;
+    bool captureHeaders = std::any_of(captures.begin(), captures.end(), [](const Capture &c) {
+        return c.headerBytes > 0;
+    });
+    if (captureHeaders) {
+        std::shared_ptr<FileReader> data = std::move(newReader);
+        auto joined = std::make_unique<ConcatenatedFile>();
+        size_t skipped = 0;
+        for (size_t i = 0; i < captures.size(); i++) {
+            skipped += captures[i].headerBytes;
+            size_t start = frames->byteOffset(captures[i].sample) + skipped;
+            size_t end = (i + 1 < captures.size()) ? frames->byteOffset(captures[i + 1].sample) + skipped : data->size();
+            if (start > end || end > data->size())
+                throw std::runtime_error("SigMF captures don't match the size of the data file");
+            joined->append(std::make_unique<FileRegion>(data, start, end - start));
+        }
+        newReader = std::move(joined);
+    }
+
+    // Join the chunks that follow a numbered one
+    QString next;
+    if (joinChunks && dataFilename == filename)
+        next = chunkAfter(dataFilename);
+    if (!next.isEmpty()) {
+        auto joined = std::make_unique<ConcatenatedFile>();
+        joined->append(std::move(newReader));
+        while (QFile::exists(next)) {
+            joined->append(openData(next));
+            next = chunkAfter(next);
+        }
+        newReader = std::move(joined);
+    }
+
+    {
+        QWriteLocker locker(&readerLock);
+        cleanup();
+
+        inputFiles = std::move(files);
+        nextChunk = next;
+        this->compression = compression;
+        reader = std::move(newReader);
+        sampleAdapter = frames;
+        channelAdapters = std::move(adapters);
+        sampleCount = sampleAdapter->samplesIn(reader->size());
+        prefetched = {0, 0};
+        _realSignal = recording.realSignal;
+        sampleRate = recording.sampleRate;
+        frequency = recording.frequency;
+        this->captures = std::move(recording.captures);
+        annotationList = std::move(recording.annotations);
+    }
+    reader->setPreload(preload);
+
+    // Covers the new rate and frequency too
+    invalidate();
+}
 
-    auto data = file->map(0, size);
-    if (data == nullptr)
-        throw std::runtime_error("Error mmapping file");
+bool InputSource::poll()
+{
+    if (inputFiles.empty() || !reader->resizable())
+        return false;
+
+    // A recorder writing chunks moves on to the next when one is full
+    std::unique_ptr<QFile> chunk;
+    std::unique_ptr<FileReader> chunkReader;
+    if (!nextChunk.isEmpty() && QFile::exists(nextChunk)) {
+        chunk = std::make_unique<QFile>(nextChunk);
+        if (!chunk->open(QFile::ReadOnly)) {
+            throw std::runtime_error(chunk->errorString().toStdString());
+        }
+        chunkReader = openReader(chunk.get(), compression, sampleAdapter->sampleSize());
+    }
+
+    size_t size = 0;
+    for (auto &file : inputFiles) {
+        size += file->size();
+    }
+    size_t newCount = sampleAdapter->samplesIn(size);
+    if (newCount == sampleCount && chunkReader == nullptr)
+        return false;
+
+    // Only the block at the old end of the file is read again, the first
+    // time it's used
+    size_t oldCount;
+    {
+        QWriteLocker locker(&readerLock);
+        reader->resize(size);
+        if (chunkReader != nullptr) {
+            // nextChunk is only set when reader joins chunks
+            static_cast<ConcatenatedFile*>(reader.get())->append(std::move(chunkReader));
+            inputFiles.push_back(std::move(chunk));
+            nextChunk = chunkAfter(nextChunk);
+        }
+        oldCount = sampleCount;
+        sampleCount = sampleAdapter->samplesIn(reader->size());
+        newCount = sampleCount;
+    }
+
+    // Only tiles covering the new samples need redrawing, unless the file
+    // was truncated or rewritten
+    if (newCount > oldCount)
+        invalidate(Invalidation::samples(oldCount, newCount));
+    else
+        invalidate();
+    return true;
+}
 
-    cleanup();
+void InputSource::prefetch(size_t start, size_t length)
+{
+    QReadLocker locker(&readerLock);
+    if (reader == nullptr)
+        return;
+
+    // Scrolling asks for mostly the same samples again, so only hint the
+    // part that wasn't hinted last time
+    range_t<size_t> hint{start, start + length};
+    QMutexLocker ml(&prefetchedMutex);
+    if (hint.minimum >= prefetched.minimum && hint.minimum < prefetched.maximum)
+        hint.minimum = std::min(prefetched.maximum, hint.maximum);
+    else if (hint.maximum > prefetched.minimum && hint.maximum <= prefetched.maximum)
+        hint.maximum = std::max(prefetched.minimum, hint.minimum);
+    prefetched = {start, start + length};
+    ml.unlock();
+
+    if (hint.length() > 0) {
+        size_t offset = sampleAdapter->byteOffset(hint.minimum);
+        reader->prefetch(offset, sampleAdapter->byteOffset(hint.maximum - 1) + sampleAdapter->sampleSize() - offset);
+    }
+}
 
-    inputFile = file.release();
-    mmapData = data;
+void InputSource::setPreload(bool enabled)
+{
+    preload = enabled;
+    if (reader != nullptr)
+        reader->setPreload(enabled);
+}
 
-    invalidate();
+void InputSource::setBufferedReads(bool enabled)
+{
+    bufferedReads = enabled;
+}
+
+void InputSource::setJoinChunks(bool enabled)
+{
+    joinChunks = enabled;
 }
 
 void InputSource::setSampleRate(double rate)
 {
     sampleRate = rate;
-    invalidate();
+    invalidate(Invalidation::metadata());
 }
 
 double InputSource::rate()
@@ -461,12 +726,35 @@ double InputSource::rate()
     return sampleRate;
 }
 
+double InputSource::captureFrequency(size_t sample)
+{
+    auto it = std::upper_bound(captures.begin(), captures.end(), sample, [](size_t sample, const Capture &capture) {
+        return sample < capture.sample;
+    });
+    if (it == captures.begin())
+        return getFrequency();
+    return (it - 1)->frequency;
+}
+
 std::unique_ptr<std::complex<float>[]> InputSource::getSamples(size_t start, size_t length)
 {
-    if (inputFile == nullptr)
+    return getSamples(0, start, length);
+}
+
+std::unique_ptr<std::complex<float>[]> InputSource::getSamples(int channel, size_t start, size_t length)
+{
+    QReadLocker locker(&readerLock);
+
+    if (inputFiles.empty())
+        return nullptr;
+
+    if (channel < 0 || channel >= (int)channelAdapters.size())
         return nullptr;
+    // Every channel's adapter reads whole frames, so sizes and offsets
+    // come from the same one that copies the samples
+    auto &adapter = channelAdapters[channel];
 
-    if (mmapData == nullptr)
+    if (reader == nullptr)
         return nullptr;
 
     if(start < 0 || length < 0)
@@ -476,7 +764,37 @@ std::unique_ptr<std::complex<float>[]> InputSource::getSamples(size_t start, siz
         return nullptr;
 
     auto dest = std::make_unique<std::complex<float>[]>(length);
-    sampleAdapter->copyRange(mmapData, start, length, dest.get());
+    TraceScope trace("InputSource::getSamples");
+    auto readStart = PerfStats::now();
+    const size_t sampleSize = adapter->sampleSize();
+    std::vector<uchar> split;
+    for (size_t done = 0; done < length;) {
+        // Packed formats may start part way into a pack
+        size_t offset = adapter->byteOffset(start + done);
+        size_t skip = (start + done) % adapter->samplesPerPack();
+        auto block = reader->block(offset);
+        if (block == nullptr)
+            return nullptr;
+
+        size_t available = adapter->samplesIn(block->offset + block->length - offset);
+        if (available > skip) {
+            size_t count = std::min(length - done, available - skip);
+            adapter->copyRange(block->data + (offset - block->offset), skip, count, &dest[done]);
+            done += count;
+            continue;
+        }
+
+        // A sample split between blocks that don't overlap (e.g. frames of
+        // a compressed file) is put back together first
+        split.resize(sampleSize);
+        if (!reader->read(offset, sampleSize, split.data()))
+            return nullptr;
+        size_t count = std::min(length - done, adapter->samplesPerPack() - skip);
+        adapter->copyRange(split.data(), skip, count, &dest[done]);
+        done += count;
+    }
+    PerfStats::add(PerfStats::inputSamples, length);
+    PerfStats::add(PerfStats::inputNs, PerfStats::now() - readStart);
 
     return dest;
 }
@@ -484,3 +802,8 @@ std::unique_ptr<std::complex<float>[]> InputSource::getSamples(size_t start, siz
 void InputSource::setFormat(std::string fmt){
     _fmt = fmt;
 }
+
+void InputSource::setChannels(int count)
+{
+    _channels = count;
+}
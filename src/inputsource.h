@@ -22,40 +22,92 @@
 
 #include <complex>
 #include <QFile>
+#include <QMutex>
+#include <QReadWriteLock>
+#include "filereader.h"
+#include "sampleadapter.h"
 #include "samplesource.h"
 
-class SampleAdapter {
-public:
-    virtual size_t sampleSize() = 0;
-    virtual void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) = 0;
-    virtual ~SampleAdapter() { };
-};
-
 class InputSource : public SampleSource<std::complex<float>>
 {
 private:
-    QFile *inputFile = nullptr;
+    // More than one if the recording is split into chunks
+    std::vector<std::unique_ptr<QFile>> inputFiles;
+    // The chunk a recorder would write next, while following one
+    QString nextChunk;
+    std::string compression;
     size_t sampleCount = 0;
     double sampleRate = 0.0;
-    uchar *mmapData = nullptr;
-    std::unique_ptr<SampleAdapter> sampleAdapter;
+    std::unique_ptr<FileReader> reader;
+    // Held for reading while samples are copied out of reader, and for
+    // writing while it, or the file size, is changed
+    QReadWriteLock readerLock;
+    // Reads channel 0 of each frame, of all the channels' samples
+    std::shared_ptr<SampleAdapter> sampleAdapter;
+    std::vector<std::shared_ptr<SampleAdapter>> channelAdapters;
     std::string _fmt;
+    int _channels = 1;
+    bool preload = false;
+    bool bufferedReads = false;
+    bool joinChunks = true;
+    // SigMF captures, by the sample they start at
+    struct Capture
+    {
+        size_t sample;
+        double frequency;
+        size_t headerBytes;
+    };
+    std::vector<Capture> captures;
+    // What openFile learns about a recording, applied all at once when the
+    // file has been opened
+    struct Recording
+    {
+        std::shared_ptr<SampleAdapter> format;
+        bool realSignal = false;
+        int channels = 1;
+        double sampleRate = 0;
+        double frequency = 0;
+        std::vector<Capture> captures;
+        std::vector<Annotation> annotations;
+    };
+    // Samples last passed to prefetch(). Several threads may prefetch at
+    // once, and they only hold readerLock for reading, so it has its own
+    // mutex.
+    range_t<size_t> prefetched{0, 0};
+    QMutex prefetchedMutex;
     bool _realSignal = false;
 
-    QJsonObject readMetaData(const QString &filename);
+    // Fill in recording from SigMF meta data
+    QJsonObject readMetaData(const QString &filename, Recording &recording);
+    QJsonObject parseMetaData(const QByteArray &json, Recording &recording);
+    // overlap is the size of a sample, or of a frame of channels
+    std::unique_ptr<FileReader> openReader(QFile *file, const std::string &compression, size_t overlap);
 
 public:
     InputSource();
     ~InputSource();
     void cleanup();
     void openFile(const char *filename);
+    bool poll();
+    void prefetch(size_t start, size_t length);
+    void setPreload(bool enabled);
+    void setBufferedReads(bool enabled);
+    void setJoinChunks(bool enabled);
     std::unique_ptr<std::complex<float>[]> getSamples(size_t start, size_t length);
+    std::unique_ptr<std::complex<float>[]> getSamples(int channel, size_t start, size_t length);
     size_t count() {
         return sampleCount;
     };
     void setSampleRate(double rate);
     void setFormat(std::string fmt);
+    // For recordings with channels interleaved sample by sample. SigMF
+    // recordings give their own count.
+    void setChannels(int count);
+    int channelCount() {
+        return channelAdapters.size();
+    };
     double rate();
+    double captureFrequency(size_t sample) override;
     bool realSignal() {
         return _realSignal;
     };
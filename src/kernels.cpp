@@ -0,0 +1,549 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kernels.h"
+#include <algorithm>
+#include <float.h>
+#include <limits>
+#include <math.h>
+#include <string.h>
+#include "simd.h"
+
+using namespace simd;
+
+namespace kernels
+{
+
+// atan(a) for 0 <= a <= 1 (Abramowitz & Stegun 4.4.49, |error| <= 1e-5)
+static const float atanCoeffs[] = {
+    0.9998660f, -0.3302995f, 0.1801410f, -0.0851330f, 0.0208351f
+};
+
+float fastAtan2(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float a = std::min(ax, ay) / std::max(std::max(ax, ay), FLT_MIN);
+    float s = a * a;
+    float r = ((((atanCoeffs[4] * s + atanCoeffs[3]) * s + atanCoeffs[2]) * s + atanCoeffs[1]) * s + atanCoeffs[0]) * a;
+    if (ay > ax)
+        r = (float)M_PI_2 - r;
+    if (x < 0)
+        r = (float)M_PI - r;
+    return copysignf(r, y);
+}
+
+static inline v4f atan2(v4f y, v4f x)
+{
+    v4f ax = abs(x);
+    v4f ay = abs(y);
+    v4f a = min(ax, ay) / max(max(ax, ay), set1(FLT_MIN));
+    v4f s = a * a;
+    v4f r = set1(atanCoeffs[4]);
+    r = r * s + set1(atanCoeffs[3]);
+    r = r * s + set1(atanCoeffs[2]);
+    r = r * s + set1(atanCoeffs[1]);
+    r = r * s + set1(atanCoeffs[0]);
+    r = r * a;
+    r = select(greater(ay, ax), set1((float)M_PI_2) - r, r);
+    r = select(less(x, set1(0.0f)), set1((float)M_PI) - r, r);
+    // r is non-negative here, so this copies the sign of y
+    return bitOr(r, bitAnd(signMask(), y));
+}
+
+// ln(m) = 2 * atanh((m - 1) / (m + 1)), with m reduced to [sqrt(0.5), sqrt(2))
+// so the series converges quickly
+static const float logCoeffs[] = {
+    2.0f, 2.0f / 3.0f, 2.0f / 5.0f, 2.0f / 7.0f
+};
+static const float log2e = 1.44269504f;
+
+float fastLog2(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float e = (float)(int32_t)((bits >> 23) & 0xff) - 127.0f;
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > (float)M_SQRT2) {
+        m *= 0.5f;
+        e += 1.0f;
+    }
+    float z = (m - 1.0f) / (m + 1.0f);
+    float z2 = z * z;
+    float ln = (((logCoeffs[3] * z2 + logCoeffs[2]) * z2 + logCoeffs[1]) * z2 + logCoeffs[0]) * z;
+    return e + ln * log2e;
+}
+
+static inline v4f log2(v4f x)
+{
+    v4i bits = asInt(x);
+    v4f e = toFloat(shiftRightLogical(bits, 23) & set1i(0xff)) - set1(127.0f);
+    v4f m = asFloat((bits & set1i(0x007fffff)) | set1i(0x3f800000));
+    v4f big = greater(m, set1((float)M_SQRT2));
+    m = select(big, m * set1(0.5f), m);
+    e = e + bitAnd(big, set1(1.0f));
+    v4f z = (m - set1(1.0f)) / (m + set1(1.0f));
+    v4f z2 = z * z;
+    v4f ln = set1(logCoeffs[3]);
+    ln = ln * z2 + set1(logCoeffs[2]);
+    ln = ln * z2 + set1(logCoeffs[1]);
+    ln = ln * z2 + set1(logCoeffs[0]);
+    return e + ln * z * set1(log2e);
+}
+
+void phase(const std::complex<float> *in, float *out, size_t count, float gain)
+{
+    size_t i = 0;
+    const v4f g = set1(gain);
+    for (; i + 4 <= count; i += 4) {
+        v4f re, im;
+        loadComplex(&in[i], re, im);
+        store(&out[i], atan2(im, re) * g);
+    }
+    for (; i < count; i++) {
+        out[i] = fastAtan2(in[i].imag(), in[i].real()) * gain;
+    }
+}
+
+void phaseScalar(const std::complex<float> *in, float *out, size_t count, float gain)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = std::arg(in[i]) * gain;
+    }
+}
+
+void magnitudeSquared(const std::complex<float> *in, float *out, size_t count, float scale, float offset)
+{
+    size_t i = 0;
+    const v4f s = set1(scale);
+    const v4f o = set1(offset);
+    for (; i + 4 <= count; i += 4) {
+        v4f re, im;
+        loadComplex(&in[i], re, im);
+        store(&out[i], (re * re + im * im) * s + o);
+    }
+    for (; i < count; i++) {
+        out[i] = (in[i].real() * in[i].real() + in[i].imag() * in[i].imag()) * scale + offset;
+    }
+}
+
+void magnitudeSquaredScalar(const std::complex<float> *in, float *out, size_t count, float scale, float offset)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = std::norm(in[i]) * scale + offset;
+    }
+}
+
+void powerDb(const std::complex<float> *in, float *out, size_t count, float scale)
+{
+    // 10 * log10(x) = 10 * log10(2) * log2(x)
+    const float dbPerLog2 = 3.01029996f;
+    size_t i = 0;
+    const v4f s = set1(scale);
+    const v4f k = set1(dbPerLog2);
+    for (; i + 4 <= count; i += 4) {
+        v4f re, im;
+        loadComplex(&in[i], re, im);
+        store(&out[i], log2((re * re + im * im) * s) * k);
+    }
+    for (; i < count; i++) {
+        float power = in[i].real() * in[i].real() + in[i].imag() * in[i].imag();
+        out[i] = fastLog2(power * scale) * dbPerLog2;
+    }
+}
+
+void powerDbScalar(const std::complex<float> *in, float *out, size_t count, float scale)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = 10.0f * log10f(std::norm(in[i]) * scale);
+    }
+}
+
+void fmDemod(const std::complex<float> *in, float *out, size_t count, std::complex<float> prev, float gain)
+{
+    if (count == 0)
+        return;
+
+    auto d = in[0] * std::conj(prev);
+    out[0] = fastAtan2(d.imag(), d.real()) * gain;
+
+    size_t i = 1;
+    const v4f g = set1(gain);
+    for (; i + 4 <= count; i += 4) {
+        v4f re, im, pre, pim;
+        loadComplex(&in[i], re, im);
+        loadComplex(&in[i - 1], pre, pim);
+        // in[i] * conj(in[i - 1])
+        v4f dre = re * pre + im * pim;
+        v4f dim = im * pre - re * pim;
+        store(&out[i], atan2(dim, dre) * g);
+    }
+
+    for (; i < count; i++) {
+        d = in[i] * std::conj(in[i - 1]);
+        out[i] = fastAtan2(d.imag(), d.real()) * gain;
+    }
+}
+
+void fmDemodScalar(const std::complex<float> *in, float *out, size_t count, std::complex<float> prev, float gain)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = std::arg(in[i] * std::conj(prev)) * gain;
+        prev = in[i];
+    }
+}
+
+static inline int32_t value12(const uint8_t *in, size_t i)
+{
+    auto p = &in[i / 2 * 3];
+    uint32_t pack = p[0] | p[1] << 8 | p[2] << 16;
+    // Move the value to the top bits, then sign extend it back down
+    return (int32_t)(pack << ((i % 2) ? 8 : 20)) >> 20;
+}
+
+static inline int32_t value4(const uint8_t *in, size_t i)
+{
+    return (int32_t)((uint32_t)in[i / 2] << ((i % 2) ? 24 : 28)) >> 28;
+}
+
+// Four values from the three-byte packs at p and p + 3
+static inline v4i lanes12(const uint8_t *p)
+{
+    uint32_t a = p[0] | p[1] << 8 | p[2] << 16;
+    uint32_t b = p[3] | p[4] << 8 | p[5] << 16;
+    return shiftRightArithmetic(seti(a << 20, a << 8, b << 20, b << 8), 20);
+}
+
+// Four values from the bytes at p and p + 1
+static inline v4i lanes4(const uint8_t *p)
+{
+    uint32_t a = p[0] | p[1] << 8;
+    return shiftRightArithmetic(seti(a << 28, a << 24, a << 20, a << 16), 28);
+}
+
+// Convert values four at a time with lanes(i), which returns values i to
+// i + 3, then the rest one by one with value(i)
+template<typename Lanes, typename Value>
+static void convert(std::complex<float> *out, size_t count, bool complex, float scale, Lanes lanes, Value value)
+{
+    const size_t values = complex ? count * 2 : count;
+    auto f = reinterpret_cast<float*>(out);
+    const v4f k = set1(scale);
+    size_t i = 0;
+    for (; i + 4 <= values; i += 4) {
+        v4f v = lanes(i) * k;
+        if (complex)
+            store(&f[i], v);
+        else
+            storeComplex(&out[i], v, set1(0.0f));
+    }
+    for (; i < values; i++) {
+        float v = value(i) * scale;
+        if (complex)
+            f[i] = v;
+        else
+            out[i] = { v, 0.0f };
+    }
+}
+
+void unpack12(const uint8_t *in, std::complex<float> *out, size_t count, bool complex)
+{
+    convert(out, count, complex, 1.0f / 2048.0f,
+        [=](size_t i) { return toFloat(lanes12(&in[i / 4 * 6])); },
+        [=](size_t i) { return (float)value12(in, i); });
+}
+
+void unpack12Scalar(const uint8_t *in, std::complex<float> *out, size_t count, bool complex)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (complex)
+            out[i] = { value12(in, i * 2) / 2048.0f, value12(in, i * 2 + 1) / 2048.0f };
+        else
+            out[i] = { value12(in, i) / 2048.0f, 0.0f };
+    }
+}
+
+void unpack4(const uint8_t *in, std::complex<float> *out, size_t count, bool complex)
+{
+    convert(out, count, complex, 1.0f / 8.0f,
+        [=](size_t i) { return toFloat(lanes4(&in[i / 4 * 2])); },
+        [=](size_t i) { return (float)value4(in, i); });
+}
+
+void unpack4Scalar(const uint8_t *in, std::complex<float> *out, size_t count, bool complex)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (complex)
+            out[i] = { value4(in, i * 2) / 8.0f, value4(in, i * 2 + 1) / 8.0f };
+        else
+            out[i] = { value4(in, i) / 8.0f, 0.0f };
+    }
+}
+
+static inline uint32_t swap32(uint32_t v)
+{
+    return v << 24 | (v & 0xff00) << 8 | (v >> 8 & 0xff00) | v >> 24;
+}
+
+static inline v4i swap32(v4i v)
+{
+    const v4i mask = set1i(0xff00);
+    return shiftLeft(v, 24) | shiftLeft(v & mask, 8) | (shiftRightLogical(v, 8) & mask) | shiftRightLogical(v, 24);
+}
+
+static inline float bigEndian(const int16_t *p)
+{
+    uint8_t b[2];
+    memcpy(b, p, sizeof(b));
+    return (int16_t)(b[0] << 8 | b[1]);
+}
+
+static inline float bigEndian(const int32_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (int32_t)swap32(v);
+}
+
+static inline float bigEndian(const float *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    v = swap32(v);
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+static inline float bigEndian(const double *p)
+{
+    uint32_t v[2];
+    memcpy(v, p, sizeof(v));
+    uint32_t swapped[2] = { swap32(v[1]), swap32(v[0]) };
+    double d;
+    memcpy(&d, swapped, sizeof(d));
+    return d;
+}
+
+void convertBigEndian(const int16_t *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    convert(out, count, complex, scale,
+        [=](size_t i) { return toFloat(shiftRightArithmetic(swap32(loadInt16Pairs(&in[i])), 16)); },
+        [=](size_t i) { return bigEndian(&in[i]); });
+}
+
+void convertBigEndian(const int32_t *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    convert(out, count, complex, scale,
+        [=](size_t i) { return toFloat(swap32(loadInt32(&in[i]))); },
+        [=](size_t i) { return bigEndian(&in[i]); });
+}
+
+void convertBigEndian(const float *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    convert(out, count, complex, scale,
+        [=](size_t i) { return asFloat(swap32(loadInt32(&in[i]))); },
+        [=](size_t i) { return bigEndian(&in[i]); });
+}
+
+void convertBigEndian(const double *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    // SSE2 can't narrow doubles much faster than this, so only the stores
+    // are vectorized
+    convert(out, count, complex, scale,
+        [=](size_t i) {
+            float f[4] = { bigEndian(&in[i]), bigEndian(&in[i + 1]), bigEndian(&in[i + 2]), bigEndian(&in[i + 3]) };
+            return load(f);
+        },
+        [=](size_t i) { return bigEndian(&in[i]); });
+}
+
+template<typename T>
+static void convertBigEndianScalar(const T *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (complex)
+            out[i] = { bigEndian(&in[i * 2]) * scale, bigEndian(&in[i * 2 + 1]) * scale };
+        else
+            out[i] = { bigEndian(&in[i]) * scale, 0.0f };
+    }
+}
+
+void convertBigEndianScalar(const int16_t *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    convertBigEndianScalar<int16_t>(in, out, count, complex, scale);
+}
+
+void convertBigEndianScalar(const int32_t *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    convertBigEndianScalar<int32_t>(in, out, count, complex, scale);
+}
+
+void convertBigEndianScalar(const float *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    convertBigEndianScalar<float>(in, out, count, complex, scale);
+}
+
+void convertBigEndianScalar(const double *in, std::complex<float> *out, size_t count, bool complex, float scale)
+{
+    convertBigEndianScalar<double>(in, out, count, complex, scale);
+}
+
+// With size known at compile time, each copy is a single load and store
+template<size_t size>
+static void gather(const uint8_t *in, size_t stride, uint8_t *out, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        memcpy(&out[i * size], &in[i * stride], size);
+    }
+}
+
+void gather(const uint8_t *in, size_t stride, size_t size, uint8_t *out, size_t count)
+{
+    switch (size) {
+    case 1: gather<1>(in, stride, out, count); break;
+    case 2: gather<2>(in, stride, out, count); break;
+    case 3: gather<3>(in, stride, out, count); break;
+    case 4: gather<4>(in, stride, out, count); break;
+    case 8: gather<8>(in, stride, out, count); break;
+    case 16: gather<16>(in, stride, out, count); break;
+    default: gatherScalar(in, stride, size, out, count); break;
+    }
+}
+
+void gatherScalar(const uint8_t *in, size_t stride, size_t size, uint8_t *out, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < size; j++) {
+            out[i * size + j] = in[i * stride + j];
+        }
+    }
+}
+
+// xorshift32, one generator per lane. Seeds must be non-zero.
+static inline v4i nextRandom(v4i &state)
+{
+    state = state ^ shiftLeft(state, 13);
+    state = state ^ shiftRightLogical(state, 17);
+    state = state ^ shiftLeft(state, 5);
+    return state;
+}
+
+static inline uint32_t nextRandom(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Uniform in [0, 1), from the top 23 bits
+static inline v4f toUnit(v4i bits)
+{
+    return asFloat(shiftRightLogical(bits, 9) | set1i(0x3f800000)) - set1(1.0f);
+}
+
+static inline uint32_t seedLane(uint32_t seed, uint32_t lane)
+{
+    return ((seed * 4 + lane + 1) * 2654435761u) | 1;
+}
+
+template<typename T>
+static void quantize(const float *in, T *out, size_t count, float scale, float offset, bool dither, uint32_t seed,
+                     void (*storeLanes)(T*, v4i))
+{
+    const v4f s = set1(scale);
+    const v4f o = set1(offset);
+    const v4f lo = set1(std::numeric_limits<T>::min());
+    const v4f hi = set1(std::numeric_limits<T>::max());
+    v4i state = seti(seedLane(seed, 0), seedLane(seed, 1), seedLane(seed, 2), seedLane(seed, 3));
+
+    auto convert = [&](v4f x) {
+        x = x * s + o;
+        if (dither)
+            x = x + toUnit(nextRandom(state)) - toUnit(nextRandom(state));
+        // max first, so NaN becomes lo
+        return toInt(min(max(x, lo), hi));
+    };
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        storeLanes(&out[i], convert(load(&in[i])));
+    }
+
+    if (i < count) {
+        float tail[4] = { 0 };
+        T result[4];
+        std::copy(&in[i], &in[count], tail);
+        storeLanes(result, convert(load(tail)));
+        std::copy(result, result + (count - i), &out[i]);
+    }
+}
+
+template<typename T>
+static void quantizeScalar(const float *in, T *out, size_t count, float scale, float offset, bool dither, uint32_t seed)
+{
+    const float lo = std::numeric_limits<T>::min();
+    const float hi = std::numeric_limits<T>::max();
+    uint32_t state = seedLane(seed, 0);
+    for (size_t i = 0; i < count; i++) {
+        float x = in[i] * scale + offset;
+        if (dither) {
+            float a = (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+            float b = (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+            x += a - b;
+        }
+        // lo first, so NaN becomes lo
+        out[i] = (T)lrintf(std::min(std::max(lo, x), hi));
+    }
+}
+
+void quantize(const float *in, int16_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed)
+{
+    quantize<int16_t>(in, out, count, scale, offset, dither, seed, storeInt16);
+}
+
+void quantize(const float *in, int8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed)
+{
+    quantize<int8_t>(in, out, count, scale, offset, dither, seed, storeInt8);
+}
+
+void quantize(const float *in, uint8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed)
+{
+    quantize<uint8_t>(in, out, count, scale, offset, dither, seed, storeUint8);
+}
+
+void quantizeScalar(const float *in, int16_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed)
+{
+    quantizeScalar<int16_t>(in, out, count, scale, offset, dither, seed);
+}
+
+void quantizeScalar(const float *in, int8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed)
+{
+    quantizeScalar<int8_t>(in, out, count, scale, offset, dither, seed);
+}
+
+void quantizeScalar(const float *in, uint8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed)
+{
+    quantizeScalar<uint8_t>(in, out, count, scale, offset, dither, seed);
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <complex>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Vectorized DSP kernels for the hot paths of the transforms.
+ *
+ * Each kernel has a scalar reference version (suffixed Scalar) that uses
+ * libm, as a baseline for the accuracy and speed of the fast version.
+ */
+namespace kernels
+{
+
+// Maximum absolute error of fastAtan2, in radians (polynomial error plus
+// float rounding near +/-pi)
+const float atan2MaxError = 2.0e-5f;
+
+// atan2 using a polynomial approximation, accurate to atan2MaxError
+float fastAtan2(float y, float x);
+
+// Maximum absolute error of fastLog2. Zero and denormal inputs give about
+// -127 rather than -inf (about -382 dB from powerDb).
+const float log2MaxError = 1.0e-5f;
+
+// log2 using a short series on the mantissa, accurate to log2MaxError
+float fastLog2(float x);
+
+// out[i] = arg(in[i]) * gain
+void phase(const std::complex<float> *in, float *out, size_t count, float gain);
+void phaseScalar(const std::complex<float> *in, float *out, size_t count, float gain);
+
+// out[i] = |in[i]|^2 * scale + offset
+void magnitudeSquared(const std::complex<float> *in, float *out, size_t count, float scale, float offset);
+void magnitudeSquaredScalar(const std::complex<float> *in, float *out, size_t count, float scale, float offset);
+
+// out[i] = 10 * log10(|in[i]|^2 * scale)
+void powerDb(const std::complex<float> *in, float *out, size_t count, float scale);
+void powerDbScalar(const std::complex<float> *in, float *out, size_t count, float scale);
+
+// out[i] = arg(in[i] * conj(in[i - 1])) * gain, with in[-1] = prev
+void fmDemod(const std::complex<float> *in, float *out, size_t count, std::complex<float> prev, float gain);
+void fmDemodScalar(const std::complex<float> *in, float *out, size_t count, std::complex<float> prev, float gain);
+
+// Unpack signed 12-bit integers, two to every three bytes with the first
+// in the low bits (byte 0 and the low nibble of byte 1), scaled to +/-1.
+// With complex set they are I/Q pairs, otherwise each is a real sample.
+// count is the number of samples written to out.
+void unpack12(const uint8_t *in, std::complex<float> *out, size_t count, bool complex);
+void unpack12Scalar(const uint8_t *in, std::complex<float> *out, size_t count, bool complex);
+
+// The same for signed 4-bit integers, two to a byte with the first in the
+// low nibble
+void unpack4(const uint8_t *in, std::complex<float> *out, size_t count, bool complex);
+void unpack4Scalar(const uint8_t *in, std::complex<float> *out, size_t count, bool complex);
+
+// Convert big-endian values, byte swapping them on the way, scaled by
+// scale. As with unpack12, complex makes pairs of values I/Q samples.
+void convertBigEndian(const int16_t *in, std::complex<float> *out, size_t count, bool complex, float scale);
+void convertBigEndian(const int32_t *in, std::complex<float> *out, size_t count, bool complex, float scale);
+void convertBigEndian(const float *in, std::complex<float> *out, size_t count, bool complex, float scale);
+void convertBigEndian(const double *in, std::complex<float> *out, size_t count, bool complex, float scale);
+void convertBigEndianScalar(const int16_t *in, std::complex<float> *out, size_t count, bool complex, float scale);
+void convertBigEndianScalar(const int32_t *in, std::complex<float> *out, size_t count, bool complex, float scale);
+void convertBigEndianScalar(const float *in, std::complex<float> *out, size_t count, bool complex, float scale);
+void convertBigEndianScalar(const double *in, std::complex<float> *out, size_t count, bool complex, float scale);
+
+// Copy count values of size bytes, stride bytes apart in in, next to each
+// other in out, e.g. to take one channel out of interleaved samples
+void gather(const uint8_t *in, size_t stride, size_t size, uint8_t *out, size_t count);
+void gatherScalar(const uint8_t *in, size_t stride, size_t size, uint8_t *out, size_t count);
+
+// out[i] = round(in[i] * scale + offset), saturated to the output type.
+// With dither set, triangular noise of +/-1 LSB is added before rounding.
+// The noise is generated from seed, so the output is reproducible, but the
+// scalar versions use a different sequence.
+void quantize(const float *in, int16_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed);
+void quantize(const float *in, int8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed);
+void quantize(const float *in, uint8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed);
+void quantizeScalar(const float *in, int16_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed);
+void quantizeScalar(const float *in, int8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed);
+void quantizeScalar(const float *in, uint8_t *out, size_t count, float scale, float offset, bool dither, uint32_t seed);
+
+}
@@ -0,0 +1,266 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "kernels.h"
+
+/*
+ * Checks each vectorized kernel against its scalar reference, and the
+ * approximations against libm, to within the documented error bounds.
+ * Counts that aren't a multiple of the vector width cover the tails.
+ */
+
+static const size_t count = 4099;
+static int failures = 0;
+
+static void check(bool condition, const char *kernel, size_t i, double got, double expected)
+{
+    if (!condition) {
+        if (failures < 20)
+            fprintf(stderr, "FAIL: %s[%zu] = %.9g, expected %.9g\n", kernel, i, got, expected);
+        failures++;
+    }
+}
+
+// Difference between two angles, allowing for them being either side of +/-pi
+static double angleError(double a, double b)
+{
+    return std::abs(std::remainder(a - b, 2 * M_PI));
+}
+
+// Random samples with magnitudes over many orders of magnitude, so the
+// approximations are tested across their whole range of exponents
+static std::vector<std::complex<float>> randomSamples(uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+    std::uniform_real_distribution<double> exponent(-20, 20);
+    std::vector<std::complex<float>> samples(count);
+    for (auto &sample : samples) {
+        sample = std::polar(std::pow(10.0, exponent(rng)), angle(rng));
+    }
+    // Exact axes and quadrant boundaries
+    samples[0] = {1, 0};
+    samples[1] = {-1, 0};
+    samples[2] = {0, 1};
+    samples[3] = {0, -1};
+    samples[4] = {-1, -1e-30f};
+    samples[5] = {1, 1};
+    return samples;
+}
+
+static void testApproximations()
+{
+    for (auto sample : randomSamples(1)) {
+        double expected = std::atan2((double)sample.imag(), (double)sample.real());
+        float got = kernels::fastAtan2(sample.imag(), sample.real());
+        check(angleError(got, expected) <= kernels::atan2MaxError, "fastAtan2", 0, got, expected);
+    }
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<double> exponent(-37, 38);
+    for (size_t i = 0; i < count; i++) {
+        float x = std::pow(10.0, exponent(rng));
+        double expected = std::log2((double)x);
+        float got = kernels::fastLog2(x);
+        check(std::abs(got - expected) <= kernels::log2MaxError, "fastLog2", i, got, expected);
+    }
+}
+
+static void testPhase()
+{
+    auto in = randomSamples(3);
+    std::vector<float> out(count), reference(count);
+    for (float gain : {1.0f, (float)(1 / M_PI)}) {
+        kernels::phase(in.data(), out.data(), count, gain);
+        kernels::phaseScalar(in.data(), reference.data(), count, gain);
+        for (size_t i = 0; i < count; i++) {
+            double expected = std::atan2((double)in[i].imag(), (double)in[i].real()) * gain;
+            double bound = kernels::atan2MaxError * gain;
+            check(angleError(out[i] / gain, expected / gain) * gain <= bound, "phase", i, out[i], expected);
+            check(angleError(reference[i] / gain, expected / gain) * gain <= 1e-6, "phaseScalar", i, reference[i], expected);
+        }
+    }
+}
+
+static void testFmDemod()
+{
+    // Unit samples, as the discriminator sees after a limiter
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+    std::vector<std::complex<float>> in(count);
+    for (auto &sample : in) {
+        sample = std::polar(1.0, angle(rng));
+    }
+    const std::complex<float> prev(0.6f, -0.8f);
+    const float gain = 1 / M_PI;
+    std::vector<float> out(count), reference(count);
+    kernels::fmDemod(in.data(), out.data(), count, prev, gain);
+    kernels::fmDemodScalar(in.data(), reference.data(), count, prev, gain);
+
+    std::complex<double> last = prev;
+    for (size_t i = 0; i < count; i++) {
+        std::complex<double> sample = in[i];
+        double expected = std::arg(sample * std::conj(last)) * gain;
+        last = sample;
+        // Plus the rounding of the product, which is done in floats
+        double bound = (kernels::atan2MaxError + 1e-6) * gain;
+        check(angleError(out[i] / gain, expected / gain) * gain <= bound, "fmDemod", i, out[i], expected);
+        check(angleError(reference[i] / gain, expected / gain) * gain <= 1e-6 * gain, "fmDemodScalar", i, reference[i], expected);
+    }
+}
+
+static void testPower()
+{
+    auto in = randomSamples(5);
+    std::vector<float> out(count), reference(count);
+    // Keep the power in the range of normal floats
+    for (auto &sample : in) {
+        if (std::norm(sample) < 1e-30f || std::norm(sample) > 1e30f)
+            sample = std::polar(1.0f, std::arg(sample));
+    }
+
+    kernels::magnitudeSquared(in.data(), out.data(), count, 2.0f, -1.0f);
+    kernels::magnitudeSquaredScalar(in.data(), reference.data(), count, 2.0f, -1.0f);
+    for (size_t i = 0; i < count; i++) {
+        double expected = std::norm(std::complex<double>(in[i])) * 2 - 1;
+        double bound = std::abs(expected) * 1e-6 + 1e-6;
+        check(std::abs(out[i] - expected) <= bound, "magnitudeSquared", i, out[i], expected);
+        check(std::abs(reference[i] - expected) <= bound, "magnitudeSquaredScalar", i, reference[i], expected);
+    }
+
+    const float scale = 1.0f / (1024 * 1024);
+    kernels::powerDb(in.data(), out.data(), count, scale);
+    kernels::powerDbScalar(in.data(), reference.data(), count, scale);
+    for (size_t i = 0; i < count; i++) {
+        double expected = 10 * std::log10(std::norm(std::complex<double>(in[i])) * scale);
+        double bound = kernels::log2MaxError * 10 * std::log10(2.0) + 1e-5;
+        check(std::abs(out[i] - expected) <= bound, "powerDb", i, out[i], expected);
+        check(std::abs(reference[i] - expected) <= 1e-5 + std::abs(expected) * 1e-6, "powerDbScalar", i, reference[i], expected);
+    }
+}
+
+template<typename T>
+static void checkSame(const std::vector<T> &out, const std::vector<T> &reference, const char *kernel)
+{
+    for (size_t i = 0; i < out.size(); i++) {
+        check(memcmp(&out[i], &reference[i], sizeof(T)) == 0, kernel, i, 0, 0);
+    }
+}
+
+static void testFormats()
+{
+    std::mt19937 rng(6);
+    std::vector<uint8_t> raw(count * 16);
+    for (auto &byte : raw) {
+        byte = rng();
+    }
+    std::vector<std::complex<float>> out(count), reference(count);
+
+    for (bool complex : {false, true}) {
+        kernels::unpack12(raw.data(), out.data(), count, complex);
+        kernels::unpack12Scalar(raw.data(), reference.data(), count, complex);
+        checkSame(out, reference, "unpack12");
+        kernels::unpack4(raw.data(), out.data(), count, complex);
+        kernels::unpack4Scalar(raw.data(), reference.data(), count, complex);
+        checkSame(out, reference, "unpack4");
+
+        // Random doubles and floats are mostly NaN and huge values, so
+        // these check the scaling and byte order, not just finite values
+        kernels::convertBigEndian((const int16_t*)raw.data(), out.data(), count, complex, 1.0f / 32768);
+        kernels::convertBigEndianScalar((const int16_t*)raw.data(), reference.data(), count, complex, 1.0f / 32768);
+        checkSame(out, reference, "convertBigEndian<int16_t>");
+        kernels::convertBigEndian((const int32_t*)raw.data(), out.data(), count, complex, 1.0f / 2147483648.0f);
+        kernels::convertBigEndianScalar((const int32_t*)raw.data(), reference.data(), count, complex, 1.0f / 2147483648.0f);
+        checkSame(out, reference, "convertBigEndian<int32_t>");
+        kernels::convertBigEndian((const float*)raw.data(), out.data(), count, complex, 1.0f);
+        kernels::convertBigEndianScalar((const float*)raw.data(), reference.data(), count, complex, 1.0f);
+        checkSame(out, reference, "convertBigEndian<float>");
+        kernels::convertBigEndian((const double*)raw.data(), out.data(), count, complex, 1.0f);
+        kernels::convertBigEndianScalar((const double*)raw.data(), reference.data(), count, complex, 1.0f);
+        checkSame(out, reference, "convertBigEndian<double>");
+    }
+
+    for (size_t size : {1, 2, 3, 4, 6, 8, 16}) {
+        std::vector<uint8_t> gathered(count * size), gatheredReference(count * size);
+        kernels::gather(raw.data() + size, size * 3, size, gathered.data(), count / 3);
+        kernels::gatherScalar(raw.data() + size, size * 3, size, gatheredReference.data(), count / 3);
+        checkSame(gathered, gatheredReference, "gather");
+    }
+}
+
+static void testQuantize()
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> value(-1.5f, 1.5f);
+    std::vector<float> in(count);
+    for (auto &sample : in) {
+        sample = value(rng);
+    }
+    in[0] = std::numeric_limits<float>::quiet_NaN();
+    in[1] = std::numeric_limits<float>::infinity();
+    in[2] = -std::numeric_limits<float>::infinity();
+    in[3] = 0.5f / 32768;
+
+    // Without dither the versions round the same way; with it they use
+    // different noise, so only check it's within one step
+    for (bool dither : {false, true}) {
+        std::vector<int16_t> out16(count), reference16(count);
+        kernels::quantize(in.data(), out16.data(), count, 32768.0f, 0.0f, dither, 1);
+        kernels::quantizeScalar(in.data(), reference16.data(), count, 32768.0f, 0.0f, dither, 1);
+        std::vector<int8_t> out8(count), reference8(count);
+        kernels::quantize(in.data(), out8.data(), count, 128.0f, 0.0f, dither, 1);
+        kernels::quantizeScalar(in.data(), reference8.data(), count, 128.0f, 0.0f, dither, 1);
+        std::vector<uint8_t> outU8(count), referenceU8(count);
+        kernels::quantize(in.data(), outU8.data(), count, 128.0f, 127.4f, dither, 1);
+        kernels::quantizeScalar(in.data(), referenceU8.data(), count, 128.0f, 127.4f, dither, 1);
+        if (!dither) {
+            checkSame(out16, reference16, "quantize<int16_t>");
+            checkSame(out8, reference8, "quantize<int8_t>");
+            checkSame(outU8, referenceU8, "quantize<uint8_t>");
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                check(std::abs(out16[i] - reference16[i]) <= 2, "quantize<int16_t> dithered", i, out16[i], reference16[i]);
+                check(std::abs(out8[i] - reference8[i]) <= 2, "quantize<int8_t> dithered", i, out8[i], reference8[i]);
+                check(std::abs(outU8[i] - referenceU8[i]) <= 2, "quantize<uint8_t> dithered", i, outU8[i], referenceU8[i]);
+            }
+        }
+    }
+}
+
+int main()
+{
+    testApproximations();
+    testPhase();
+    testFmDemod();
+    testPower();
+    testFormats();
+    testQuantize();
+
+    if (failures == 0)
+        printf("kernels: all tests passed\n");
+    else
+        fprintf(stderr, "%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -21,6 +21,7 @@
 #include <QCommandLineParser>
 
 #include "mainwindow.h"
+#include "tracing.h"
 
 int main(int argc, char *argv[])
 {
@@ -28,6 +29,8 @@ int main(int argc, char *argv[])
     a.setApplicationName("inspectrum");
     a.setOrganizationName("inspectrum");
 
+    Trace::startFromEnvironment();
+
     MainWindow mainWin;
 
     QCommandLineParser parser;
@@ -41,22 +44,67 @@ int main(int argc, char *argv[])
                                   QCoreApplication::translate("main", "Hz"));
     parser.addOption(rateOption);
     QCommandLineOption formatOption(QStringList() << "f" << "format",
-                                  QCoreApplication::translate("main", "Set file format, options: cfile/cf32/fc32, cf64/fc64, cs32/sc32/c32, cs16/sc16/c16, cs8/sc8/c8, cu8/uc8, f32, f64, s16, s8, u8, sigmf-meta/sigmf-data."),
+                                  QCoreApplication::translate("main", "Set file format, options: cfile/cf32/fc32, cf64/fc64, cs32/sc32/c32, cs16/sc16/c16, cs8/sc8/c8, cs12/sc12/ci12, cs4/sc4/ci4, cu8/uc8, f32, f64, s16, s12, s8, s4, u8, sigmf-meta/sigmf-data. Add _be to a multi-byte format for big-endian, e.g. cs16_be."),
                                   QCoreApplication::translate("main", "fmt"));
     parser.addOption(formatOption);
+    QCommandLineOption channelsOption(QStringList() << "channels",
+                                  QCoreApplication::translate("main", "Number of channels interleaved sample by sample in the file. Each is shown in its own spectrogram."),
+                                  QCoreApplication::translate("main", "count"));
+    parser.addOption(channelsOption);
+    QCommandLineOption followOption(QStringList() << "follow",
+                                  QCoreApplication::translate("main", "Follow the file as it grows, e.g. while it is being recorded."));
+    parser.addOption(followOption);
+    QCommandLineOption preloadOption(QStringList() << "preload",
+                                  QCoreApplication::translate("main", "Read the whole file into memory in the background, for files that fit in RAM."));
+    parser.addOption(preloadOption);
+    QCommandLineOption noMmapOption(QStringList() << "no-mmap",
+                                  QCoreApplication::translate("main", "Read the file in blocks instead of mapping it, e.g. on network filesystems. Used automatically if mapping fails."));
+    parser.addOption(noMmapOption);
+    QCommandLineOption noJoinOption(QStringList() << "no-join",
+                                  QCoreApplication::translate("main", "Only open the given file, rather than also the numbered chunks after it (cap_001.cs16, cap_002.cs16, ...)."));
+    parser.addOption(noJoinOption);
+    QCommandLineOption traceOption(QStringList() << "trace",
+                                  QCoreApplication::translate("main", "Record a Chrome trace of tile, transform, read and paint jobs to file on exit (or set INSPECTRUM_TRACE)."),
+                                  QCoreApplication::translate("main", "file"));
+    parser.addOption(traceOption);
 
     // Process the actual command line
     parser.process(a);
  
+    if (parser.isSet(traceOption))
+        Trace::start(parser.value(traceOption).toStdString());
+
     // Check for file format override   
     if(parser.isSet(formatOption)){
         mainWin.setFormat(parser.value(formatOption));
     }
 
+    if (parser.isSet(channelsOption)) {
+        bool ok;
+        auto channels = parser.value(channelsOption).toInt(&ok);
+        if (!ok || channels < 1) {
+            fputs("ERROR: could not parse channels\n", stderr);
+            return 1;
+        }
+        mainWin.setChannels(channels);
+    }
+
+    if (parser.isSet(preloadOption))
+        mainWin.setPreload(true);
+
+    if (parser.isSet(noMmapOption))
+        mainWin.setBufferedReads(true);
+
+    if (parser.isSet(noJoinOption))
+        mainWin.setJoinChunks(false);
+
     const QStringList args = parser.positionalArguments();
     if (args.size()>=1)
         mainWin.openFile(args.at(0));
 
+    if (parser.isSet(followOption))
+        mainWin.setFollow(true);
+
     if (parser.isSet(rateOption)) {
         bool ok;
         auto rate = parser.value(rateOption).toDouble(&ok);
@@ -68,5 +116,7 @@ int main(int argc, char *argv[])
     }
 
     mainWin.show();
-    return a.exec();
+    auto ret = a.exec();
+    Trace::finish();
+    return ret;
 }
@@ -42,14 +42,22 @@ MainWindow::MainWindow()
     plots = new PlotView(input);
     setCentralWidget(plots);
 
+    // Polled rather than watched, as change notifications aren't available
+    // (or are unreliable) on many of the filesystems recordings are made to
+    followTimer = new QTimer(this);
+    connect(followTimer, &QTimer::timeout, this, &MainWindow::followFile);
+
     // Connect dock inputs
     connect(dock, &SpectrogramControls::openFile, this, &MainWindow::openFile);
     connect(dock->sampleRate, static_cast<void (QLineEdit::*)(const QString&)>(&QLineEdit::textChanged), this, static_cast<void (MainWindow::*)(QString)>(&MainWindow::setSampleRate));
+    connect(dock->followCheckBox, &QCheckBox::toggled, this, &MainWindow::setFollow);
+    connect(dock->autoScrollCheckBox, &QCheckBox::toggled, plots, &PlotView::enableAutoScroll);
     connect(dock, static_cast<void (SpectrogramControls::*)(int, int)>(&SpectrogramControls::fftOrZoomChanged), plots, &PlotView::setFFTAndZoom);
     connect(dock->powerMaxSlider, &QSlider::valueChanged, plots, &PlotView::setPowerMax);
     connect(dock->powerMinSlider, &QSlider::valueChanged, plots, &PlotView::setPowerMin);
     connect(dock->cursorsCheckBox, &QCheckBox::stateChanged, plots, &PlotView::enableCursors);
     connect(dock->scalesCheckBox, &QCheckBox::stateChanged, plots, &PlotView::enableScales);
+    connect(dock->perfHudCheckBox, &QCheckBox::stateChanged, plots, &PlotView::enablePerfHud);
     connect(dock->annosCheckBox, &QCheckBox::stateChanged, plots, &PlotView::enableAnnotations);
     connect(dock->annosCheckBox, &QCheckBox::stateChanged, dock, &SpectrogramControls::enableAnnotations);
     connect(dock->commentsCheckBox, &QCheckBox::stateChanged, plots, &PlotView::enableAnnotationCommentsTooltips);
@@ -101,8 +109,12 @@ void MainWindow::openFile(QString fileName)
     }
 }
 
-void MainWindow::invalidateEvent()
+void MainWindow::invalidateEvent(const Invalidation &invalidation)
 {
+    // New samples don't change the rate
+    if (invalidation.type == Invalidation::Samples)
+        return;
+
     plots->setSampleRate(input->rate());
 
     // Only update the text box if it is not already representing
@@ -134,3 +146,50 @@ void MainWindow::setFormat(QString fmt)
 {
     input->setFormat(fmt.toUtf8().constData());
 }
+
+void MainWindow::setChannels(int count)
+{
+    input->setChannels(count);
+}
+
+void MainWindow::setPreload(bool enabled)
+{
+    input->setPreload(enabled);
+}
+
+void MainWindow::setBufferedReads(bool enabled)
+{
+    input->setBufferedReads(enabled);
+}
+
+void MainWindow::setJoinChunks(bool enabled)
+{
+    input->setJoinChunks(enabled);
+}
+
+void MainWindow::setFollow(bool enabled)
+{
+    if (dock->followCheckBox->isChecked() != enabled) {
+        dock->followCheckBox->setChecked(enabled);
+        return;
+    }
+
+    if (enabled)
+        followTimer->start(250);
+    else
+        followTimer->stop();
+}
+
+void MainWindow::followFile()
+{
+    try
+    {
+        input->poll();
+    }
+    catch (const std::exception &ex)
+    {
+        setFollow(false);
+        QMessageBox msgBox(QMessageBox::Critical, "Inspectrum follow error", ex.what());
+        msgBox.exec();
+    }
+}
@@ -21,6 +21,7 @@
 
 #include <QMainWindow>
 #include <QScrollArea>
+#include <QTimer>
 #include "spectrogramcontrols.h"
 #include "plotview.h"
 
@@ -37,10 +38,17 @@ public slots:
     void setSampleRate(QString rate);
     void setSampleRate(double rate);
     void setFormat(QString fmt);
-    void invalidateEvent() override;
+    void setChannels(int count);
+    void setFollow(bool enabled);
+    void setPreload(bool enabled);
+    void setBufferedReads(bool enabled);
+    void setJoinChunks(bool enabled);
+    void followFile();
+    void invalidateEvent(const Invalidation &invalidation) override;
 
 private:
     SpectrogramControls *dock;
     PlotView *plots;
     InputSource *input;
+    QTimer *followTimer;
 };
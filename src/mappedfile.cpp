@@ -0,0 +1,157 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGlobal>
+#include <algorithm>
+#include "mappedfile.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedFile::Window::~Window()
+{
+    QMutexLocker locker(&owner->mutex);
+    owner->file->unmap(const_cast<uchar*>(data));
+}
+
+MappedFile::MappedFile(QFile *file, size_t overlap, size_t windowSize, int maxWindows)
+    : file(file), fileSize(file->size()), overlap(overlap), windowSize(windowSize), maxWindows(maxWindows)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    // Windows lock the mutex as they unmap themselves
+    windows.clear();
+}
+
+size_t MappedFile::windowLength(size_t offset)
+{
+    return std::min(fileSize, offset + windowSize + overlap) - offset;
+}
+
+void MappedFile::resize(size_t size)
+{
+    // Destroyed after the mutex is released, as unmapping takes it
+    std::vector<std::shared_ptr<Window>> stale;
+    QMutexLocker locker(&mutex);
+
+    fileSize = size;
+    for (auto it = windows.begin(); it != windows.end();) {
+        auto &w = *it;
+        if (w->offset >= fileSize || w->length != windowLength(w->offset)) {
+            stale.push_back(std::move(w));
+            it = windows.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+std::shared_ptr<const FileReader::Block> MappedFile::block(size_t offset)
+{
+    std::vector<std::shared_ptr<Window>> evicted;
+    QMutexLocker locker(&mutex);
+
+    if (offset >= fileSize)
+        return nullptr;
+
+    size_t start = offset - offset % windowSize;
+    for (auto it = windows.begin(); it != windows.end(); it++) {
+        if ((*it)->offset == start) {
+            windows.splice(windows.begin(), windows, it);
+            return windows.front();
+        }
+    }
+
+    size_t length = windowLength(start);
+    auto data = file->map(start, length);
+    if (data == nullptr)
+        return nullptr;
+
+    windows.push_front(std::make_shared<Window>(this, data, start, length));
+    adviseWindow(*windows.front());
+    while (windows.size() > (size_t)maxWindows) {
+        evicted.push_back(std::move(windows.back()));
+        windows.pop_back();
+    }
+    return windows.front();
+}
+
+void MappedFile::prefetch(size_t offset, size_t length)
+{
+    if (offset >= fileSize)
+        return;
+    length = std::min(length, fileSize - offset);
+
+#if defined(Q_OS_UNIX) && defined(POSIX_FADV_WILLNEED)
+    // Works on the file rather than a mapping, so it also covers windows
+    // that aren't mapped yet
+    posix_fadvise(file->handle(), offset, length, POSIX_FADV_WILLNEED);
+#elif defined(Q_OS_UNIX)
+    QMutexLocker locker(&mutex);
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    for (auto &w : windows) {
+        size_t start = std::max(offset, w->offset);
+        size_t end = std::min(offset + length, w->offset + w->length);
+        if (start >= end)
+            continue;
+        start -= (start - w->offset) % pageSize;
+        madvise(const_cast<uchar*>(w->data) + (start - w->offset), end - start, MADV_WILLNEED);
+    }
+#else
+    Q_UNUSED(offset);
+    Q_UNUSED(length);
+#endif
+}
+
+void MappedFile::setPreload(bool enabled)
+{
+    {
+        QMutexLocker locker(&mutex);
+        preload = enabled;
+        if (enabled) {
+            for (auto &w : windows)
+                adviseWindow(*w);
+        }
+    }
+    if (enabled)
+        prefetch(0, fileSize);
+}
+
+// Called with mutex held
+void MappedFile::adviseWindow(const Window &window)
+{
+#ifdef Q_OS_UNIX
+    if (!preload)
+        return;
+
+    // Windows start on a multiple of windowSize, so are page aligned
+    auto data = const_cast<uchar*>(window.data);
+#ifdef MADV_HUGEPAGE
+    madvise(data, window.length, MADV_HUGEPAGE);
+#endif
+    madvise(data, window.length, MADV_WILLNEED);
+#else
+    Q_UNUSED(window);
+#endif
+}
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QMutex>
+#include <list>
+#include <memory>
+#include <vector>
+#include "filereader.h"
+
+/*
+ * Maps a file in fixed-size windows as they are needed, keeping only the
+ * most recently used ones mapped, so the address space and page tables
+ * used stay bounded however large the file is.
+ */
+class MappedFile : public FileReader
+{
+public:
+    static const size_t defaultWindowSize = 256 * 1024 * 1024;
+    static const int defaultMaxWindows = 16;
+
+    // Each window also maps the first overlap bytes of the next one. file
+    // must stay open for the lifetime of the MappedFile and its windows.
+    MappedFile(QFile *file, size_t overlap, size_t windowSize = defaultWindowSize, int maxWindows = defaultMaxWindows);
+    ~MappedFile();
+
+    size_t size() override { return fileSize; };
+    void resize(size_t size) override;
+    std::shared_ptr<const Block> block(size_t offset) override;
+    void prefetch(size_t offset, size_t length) override;
+    // Also asks for windows to be backed by huge pages where the
+    // filesystem allows
+    void setPreload(bool enabled) override;
+
+private:
+    // A mapped block, unmapped when the last reader lets go of it
+    struct Window : Block
+    {
+        Window(MappedFile *owner, uchar *data, size_t offset, size_t length)
+            : Block(data, offset, length), owner(owner) { };
+        ~Window();
+
+        MappedFile *owner;
+    };
+
+    QFile *file;
+    size_t fileSize;
+    size_t overlap;
+    size_t windowSize;
+    int maxWindows;
+    bool preload = false;
+
+    // Protects windows, and mapping and unmapping file
+    QMutex mutex;
+    // Most recently used first
+    std::list<std::shared_ptr<Window>> windows;
+
+    size_t windowLength(size_t offset);
+    void adviseWindow(const Window &window);
+};
@@ -0,0 +1,129 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perfhud.h"
+#include <QFontDatabase>
+#include <QThreadPool>
+#include <algorithm>
+#include "perfstats.h"
+
+static QString hitRate(uint64_t hits, uint64_t misses)
+{
+    if (hits + misses == 0)
+        return "-";
+    return QString("%1%").arg(100.0 * hits / (hits + misses), 0, 'f', 0);
+}
+
+PerfHud::PerfHud() : last(snapshot())
+{
+}
+
+PerfHud::Snapshot PerfHud::snapshot()
+{
+    auto get = [](const std::atomic<uint64_t> &counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+    return {
+        PerfStats::now(),
+        get(PerfStats::fftCache.hits), get(PerfStats::fftCache.misses),
+        get(PerfStats::pixmapCache.hits), get(PerfStats::pixmapCache.misses),
+        get(PerfStats::traceCache.hits), get(PerfStats::traceCache.misses),
+        get(PerfStats::workerBusyNs),
+        get(PerfStats::inputSamples), get(PerfStats::inputNs)
+    };
+}
+
+void PerfHud::frameFinished(uint64_t paintNs)
+{
+    frames++;
+    framesNs += paintNs;
+    maxFrameNs = std::max(maxFrameNs, paintNs);
+    lastFrameMs = paintNs / 1e6;
+}
+
+void PerfHud::update()
+{
+    auto now = snapshot();
+    auto elapsed = now.time - last.time;
+    if (elapsed < window && !windowLines.isEmpty())
+        return;
+
+    auto threads = QThreadPool::globalInstance()->maxThreadCount();
+    double utilisation = 100.0 * (now.workerBusyNs - last.workerBusyNs) / ((double)std::max(elapsed, (uint64_t)1) * threads);
+    auto inputNs = now.inputNs - last.inputNs;
+    auto inputSamples = now.inputSamples - last.inputSamples;
+
+    windowLines.clear();
+    windowLines << QString("Paint: %1 ms mean, %2 ms max (%3 frames)")
+        .arg(frames ? framesNs / 1e6 / frames : 0.0, 0, 'f', 1)
+        .arg(maxFrameNs / 1e6, 0, 'f', 1)
+        .arg(frames);
+    windowLines << QString("Spectrogram cache hits: FFT %1, pixmap %2")
+        .arg(hitRate(now.fftHits - last.fftHits, now.fftMisses - last.fftMisses))
+        .arg(hitRate(now.pixmapHits - last.pixmapHits, now.pixmapMisses - last.pixmapMisses));
+    windowLines << QString("Trace cache hits: %1")
+        .arg(hitRate(now.traceHits - last.traceHits, now.traceMisses - last.traceMisses));
+    windowLines << QString("Workers: %1% busy of %2 threads")
+        .arg(std::min(utilisation, 100.0), 0, 'f', 0)
+        .arg(threads);
+    if (inputNs > 0) {
+        windowLines << QString("Input: %1 Msamples/s, %2 Msamples read")
+            .arg(inputSamples * 1e3 / inputNs, 0, 'f', 0)
+            .arg(inputSamples / 1e6, 0, 'f', 1);
+    } else {
+        windowLines << QString("Input: idle");
+    }
+
+    last = now;
+    frames = 0;
+    framesNs = 0;
+    maxFrameNs = 0;
+}
+
+void PerfHud::paint(QPainter &painter, const QRect &rect)
+{
+    update();
+
+    // Counts that are only meaningful right now aren't averaged
+    QStringList lines;
+    lines << QString("Last frame: %1 ms").arg(lastFrameMs, 0, 'f', 1);
+    lines << QString("Trace tiles: %1 pending, %2 in flight")
+        .arg(std::max(PerfStats::tilesPending.load(std::memory_order_relaxed), 0))
+        .arg(std::max(PerfStats::tilesInFlight.load(std::memory_order_relaxed), 0));
+    lines << windowLines;
+
+    painter.save();
+    painter.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    QFontMetrics fm(painter.font());
+    int width = 0;
+    for (auto &line : lines) {
+        width = std::max(width, fm.boundingRect(line).width());
+    }
+    const int margin = 6;
+    QRect box(rect.right() - width - 3 * margin, rect.top() + margin + 30,
+              width + 2 * margin, lines.size() * fm.height() + 2 * margin);
+    painter.fillRect(box, QColor(0, 0, 0, 180));
+    painter.setPen(Qt::white);
+    int y = box.top() + margin + fm.ascent();
+    for (auto &line : lines) {
+        painter.drawText(box.left() + margin, y, line);
+        y += fm.height();
+    }
+    painter.restore();
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QPainter>
+#include <QStringList>
+#include <stdint.h>
+
+/*
+ * Overlay showing paint times and the PerfStats counters. Rates are
+ * averaged over half-second windows, so the text is readable while
+ * scrolling.
+ */
+class PerfHud
+{
+public:
+    PerfHud();
+    void frameFinished(uint64_t paintNs);
+    void paint(QPainter &painter, const QRect &rect);
+
+private:
+    struct Snapshot {
+        uint64_t time;
+        uint64_t fftHits, fftMisses;
+        uint64_t pixmapHits, pixmapMisses;
+        uint64_t traceHits, traceMisses;
+        uint64_t workerBusyNs;
+        uint64_t inputSamples, inputNs;
+    };
+
+    static const uint64_t window = 500000000;
+
+    Snapshot last;
+    uint64_t frames = 0;
+    uint64_t framesNs = 0;
+    uint64_t maxFrameNs = 0;
+    double lastFrameMs = 0;
+    QStringList windowLines;
+
+    static Snapshot snapshot();
+    void update();
+};
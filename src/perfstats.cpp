@@ -0,0 +1,31 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perfstats.h"
+
+PerfStats::Cache PerfStats::fftCache;
+PerfStats::Cache PerfStats::pixmapCache;
+PerfStats::Cache PerfStats::traceCache;
+
+std::atomic<int> PerfStats::tilesPending{0};
+std::atomic<int> PerfStats::tilesInFlight{0};
+std::atomic<uint64_t> PerfStats::workerBusyNs{0};
+
+std::atomic<uint64_t> PerfStats::inputSamples{0};
+std::atomic<uint64_t> PerfStats::inputNs{0};
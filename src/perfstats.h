@@ -0,0 +1,83 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+/*
+ * Counters behind the performance overlay. They are relaxed atomics that
+ * are updated once per tile or read rather than per sample, so they are
+ * always collected, whether or not the overlay is shown.
+ */
+class PerfStats
+{
+public:
+    struct Cache {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+
+        void lookup(bool hit) {
+            (hit ? hits : misses).fetch_add(1, std::memory_order_relaxed);
+        };
+    };
+
+    static Cache fftCache;
+    static Cache pixmapCache;
+    static Cache traceCache;
+
+    // Trace tiles queued for a worker thread, and being drawn
+    static std::atomic<int> tilesPending;
+    static std::atomic<int> tilesInFlight;
+    // Total time worker threads have spent drawing tiles
+    static std::atomic<uint64_t> workerBusyNs;
+
+    // Samples converted by the input adapter, and the time it took
+    static std::atomic<uint64_t> inputSamples;
+    static std::atomic<uint64_t> inputNs;
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+
+    static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    };
+
+    // Counts a queued tile as in flight, and its time as worker time, for
+    // the lifetime of the object
+    class WorkerTask
+    {
+    public:
+        WorkerTask() : start(now()) {
+            tilesPending.fetch_sub(1, std::memory_order_relaxed);
+            tilesInFlight.fetch_add(1, std::memory_order_relaxed);
+        };
+        ~WorkerTask() {
+            add(workerBusyNs, now() - start);
+            tilesInFlight.fetch_sub(1, std::memory_order_relaxed);
+        };
+
+    private:
+        uint64_t start;
+    };
+};
@@ -18,6 +18,7 @@
  */
 
 #include "phasedemod.h"
+#include "kernels.h"
 
 PhaseDemod::PhaseDemod(std::shared_ptr<SampleSource<std::complex<float>>> src) : SampleBuffer(src)
 {
@@ -28,7 +29,5 @@ void PhaseDemod::work(void *input, void *output, int count, size_t sampleid)
 {
     auto in = static_cast<std::complex<float>*>(input);
     auto out = static_cast<float*>(output);
-    for (int i = 0; i < count; i++) {
-        out[i] = std::arg(in[i]) * (1 / M_PI);
-    }
+    kernels::phase(in, out, count, 1 / M_PI);
 }
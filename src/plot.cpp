@@ -29,7 +29,7 @@ Plot::~Plot()
     sampleSource->unsubscribe(this);
 }
 
-void Plot::invalidateEvent()
+void Plot::invalidateEvent(const Invalidation &invalidation)
 {
 
 }
@@ -32,7 +32,7 @@ class Plot : public QObject, public Subscriber
 public:
     Plot(std::shared_ptr<AbstractSampleSource> src);
     ~Plot();
-    void invalidateEvent() override;
+    void invalidateEvent(const Invalidation &invalidation) override;
     virtual bool mouseEvent(QEvent::Type type, QMouseEvent *event);
     virtual void leaveEvent();
     virtual std::shared_ptr<AbstractSampleSource> output();
@@ -40,6 +40,10 @@ public:
     virtual void paintMid(QPainter &painter, QRect &rect, range_t<size_t> sampleRange);
     virtual void paintFront(QPainter &painter, QRect &rect, range_t<size_t> sampleRange);
     int height() const { return _height; };
+    // Samples of the file for each sample of this plot's source, for
+    // sources at a lower rate, e.g. channelizer outputs
+    int decimation() const { return _decimation; };
+    void setDecimation(int decimation) { _decimation = decimation; };
 
 signals:
     void repaint();
@@ -52,4 +56,5 @@ protected:
 private:
     // TODO: don't hardcode this
     int _height = 200;
+    int _decimation = 1;
 };
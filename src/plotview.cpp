@@ -19,23 +19,38 @@
 
 #include "plotview.h"
 #include <iostream>
-#include <fstream>
 #include <QtGlobal>
 #include <QApplication>
+#include <QCheckBox>
 #include <QClipboard>
 #include <QDebug>
+#include <QDoubleSpinBox>
 #include <QFileDialog>
+#include <QFormLayout>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QMenu>
+#include <QMessageBox>
 #include <QPainter>
 #include <QProgressDialog>
 #include <QRadioButton>
 #include <QScrollBar>
 #include <QSpinBox>
+#include <QTimer>
 #include <QToolTip>
 #include <QVBoxLayout>
+#include "channelizer.h"
+#include "inputchannel.h"
+#include "perfstats.h"
 #include "plots.h"
+#include "sampleexporter.h"
+#include "tracing.h"
+
+// The samples of a source decimated by decimation that cover range of the file
+static range_t<size_t> decimated(range_t<size_t> range, int decimation)
+{
+    return {range.minimum / decimation, range.maximum / decimation};
+}
 
 PlotView::PlotView(InputSource *input) : cursors(this), viewRange({0, 0})
 {
@@ -54,6 +69,10 @@ PlotView::PlotView(InputSource *input) : cursors(this), viewRange({0, 0})
     enableAnnotations(true);
     enableAnnotationCommentsTooltips(true);
 
+    // Keep the overlay's counters moving while nothing else repaints
+    perfHudTimer = new QTimer(this);
+    connect(perfHudTimer, &QTimer::timeout, this, &PlotView::repaint);
+
     addPlot(spectrogramPlot);
 
     mainSampleSource->subscribe(this);
@@ -125,6 +144,7 @@ void PlotView::contextMenuEvent(QContextMenuEvent * event)
     // that are compatible with selectedPlot's output
     QMenu *plotsMenu = menu.addMenu("Add derived plot");
     auto src = selectedPlot->output();
+    auto decimation = selectedPlot->decimation();
     auto compatiblePlots = as_range(Plots::plots.equal_range(src->sampleType()));
     for (auto p : compatiblePlots) {
         auto plotInfo = p.second;
@@ -133,12 +153,28 @@ void PlotView::contextMenuEvent(QContextMenuEvent * event)
         connect(
             action, &QAction::triggered,
             this, [=]() {
-                addPlot(plotCreator(src));
+                auto plot = plotCreator(src);
+                plot->setDecimation(decimation);
+                addPlot(plot);
             }
         );
         plotsMenu->addAction(action);
     }
 
+    // Add actions to split complex outputs into channels, with a plot each
+    QMenu *channelsMenu = menu.addMenu("Split into channels");
+    for (int channels : {2, 4, 8, 16, 32}) {
+        auto action = new QAction(QString("%1 channels").arg(channels), channelsMenu);
+        connect(
+            action, &QAction::triggered,
+            this, [=]() {
+                addChannelPlots(src, decimation, channels);
+            }
+        );
+        channelsMenu->addAction(action);
+    }
+    channelsMenu->setEnabled(src->sampleType() == typeid(std::complex<float>));
+
     // Add submenu for extracting symbols
     QMenu *extractMenu = menu.addMenu("Extract symbols");
     // Add action to extract symbols from selected plot to stdout
@@ -146,7 +182,7 @@ void PlotView::contextMenuEvent(QContextMenuEvent * event)
     connect(
         extract, &QAction::triggered,
         this, [=]() {
-            extractSymbols(src, false);
+            extractSymbols(src, decimation, false);
         }
     );
     extract->setEnabled(cursorsEnabled && (src->sampleType() == typeid(float)));
@@ -157,7 +193,7 @@ void PlotView::contextMenuEvent(QContextMenuEvent * event)
     connect(
         extractClipboard, &QAction::triggered,
         this, [=]() {
-            extractSymbols(src, true);
+            extractSymbols(src, decimation, true);
         }
     );
     extractClipboard->setEnabled(cursorsEnabled && (src->sampleType() == typeid(float)));
@@ -169,9 +205,9 @@ void PlotView::contextMenuEvent(QContextMenuEvent * event)
         save, &QAction::triggered,
         this, [=]() {
             if (selectedPlot == spectrogramPlot) {
-                exportSamples(spectrogramPlot->tunerEnabled() ? spectrogramPlot->output() : spectrogramPlot->input());
+                exportSamples(spectrogramPlot->tunerEnabled() ? spectrogramPlot->output() : spectrogramPlot->input(), 1);
             } else {
-                exportSamples(src);
+                exportSamples(src, decimation);
             }
         }
     );
@@ -182,6 +218,7 @@ void PlotView::contextMenuEvent(QContextMenuEvent * event)
     connect(
         rem, &QAction::triggered,
         this, [=]() {
+            channelPlots.erase(std::remove(channelPlots.begin(), channelPlots.end(), selectedPlot), channelPlots.end());
             plots.erase(it);
         }
     );
@@ -194,6 +231,21 @@ void PlotView::contextMenuEvent(QContextMenuEvent * event)
         updateView(false);
 }
 
+void PlotView::addChannelPlots(std::shared_ptr<AbstractSampleSource> src, int decimation, int channels)
+{
+    auto complexSrc = std::dynamic_pointer_cast<SampleSource<std::complex<float>>>(src);
+    if (!complexSrc)
+        return;
+
+    // The outputs keep the channelizer alive for as long as their plots
+    auto channelizer = std::make_shared<Channelizer>(complexSrc, channels);
+    for (int k = 0; k < channels; k++) {
+        auto plot = Plots::samplePlot(channelizer->channel(k));
+        plot->setDecimation(decimation * channels);
+        addPlot(plot);
+    }
+}
+
 void PlotView::cursorsMoved()
 {
     selectedSamples = {
@@ -301,7 +353,7 @@ bool PlotView::viewportEvent(QEvent *event) {
     return QGraphicsView::viewportEvent(event);
 }
 
-void PlotView::extractSymbols(std::shared_ptr<AbstractSampleSource> src,
+void PlotView::extractSymbols(std::shared_ptr<AbstractSampleSource> src, int decimation,
                               bool toClipboard)
 {
     if (!cursorsEnabled)
@@ -309,10 +361,13 @@ void PlotView::extractSymbols(std::shared_ptr<AbstractSampleSource> src,
     auto floatSrc = std::dynamic_pointer_cast<SampleSource<float>>(src);
     if (!floatSrc)
         return;
-    auto samples = floatSrc->getSamples(selectedSamples.minimum, selectedSamples.length());
-    auto step = (float)selectedSamples.length() / cursors.segments();
+    auto selection = decimated(selectedSamples, decimation);
+    auto samples = floatSrc->getSamples(selection.minimum, selection.length());
+    if (samples == nullptr)
+        return;
+    auto step = (float)selection.length() / cursors.segments();
     auto symbols = std::vector<float>();
-    for (auto i = step / 2; i < selectedSamples.length(); i += step)
+    for (auto i = step / 2; i < selection.length(); i += step)
     {
         symbols.push_back(samples[i]);
     }
@@ -330,17 +385,17 @@ void PlotView::extractSymbols(std::shared_ptr<AbstractSampleSource> src,
     }
 }
 
-void PlotView::exportSamples(std::shared_ptr<AbstractSampleSource> src)
+void PlotView::exportSamples(std::shared_ptr<AbstractSampleSource> src, int decimation)
 {
     if (src->sampleType() == typeid(std::complex<float>)) {
-        exportSamples<std::complex<float>>(src);
+        exportSamples<std::complex<float>>(src, decimation);
     } else {
-        exportSamples<float>(src);
+        exportSamples<float>(src, decimation);
     }
 }
 
 template<typename SOURCETYPE>
-void PlotView::exportSamples(std::shared_ptr<AbstractSampleSource> src)
+void PlotView::exportSamples(std::shared_ptr<AbstractSampleSource> src, int sourceDecimation)
 {
     auto sampleSrc = std::dynamic_pointer_cast<SampleSource<SOURCETYPE>>(src);
     if (!sampleSrc) {
@@ -350,7 +405,17 @@ void PlotView::exportSamples(std::shared_ptr<AbstractSampleSource> src)
     QFileDialog dialog(this);
     dialog.setAcceptMode(QFileDialog::AcceptSave);
     dialog.setFileMode(QFileDialog::AnyFile);
-    dialog.setNameFilter(getFileNameFilter<SOURCETYPE>());
+    bool complex = std::is_same<SOURCETYPE, std::complex<float>>::value;
+    const std::vector<ExportFormat> formats = {
+        ExportFormat::Float32, ExportFormat::Int16, ExportFormat::Int8, ExportFormat::Uint8
+    };
+    dialog.setNameFilters({
+        getFileNameFilter<SOURCETYPE>(),
+        complex ? "complex<int16> file (*.cs16)" : "int16 file (*.s16)",
+        complex ? "complex<int8> file (*.cs8)" : "int8 file (*.s8)",
+        complex ? "complex<uint8> file (*.cu8)" : "uint8 file (*.u8)",
+        complex ? "SigMF complex<float> (*.sigmf-data)" : "SigMF float (*.sigmf-data)",
+    });
     dialog.setOption(QFileDialog::DontUseNativeDialog, true);
 
     QGroupBox groupBox("Selection To Export", &dialog);
@@ -388,51 +453,130 @@ void PlotView::exportSamples(std::shared_ptr<AbstractSampleSource> src)
     groupBox2.setLayout(&vbox2);
     l->addWidget(&groupBox2, 4, 2);
 
+    QGroupBox groupBox3("Integer Formats");
+    QFormLayout form3(&groupBox3);
+    QDoubleSpinBox scale(&groupBox3);
+    scale.setRange(0.001, 1000);
+    scale.setDecimals(3);
+    scale.setValue(1);
+    QCheckBox dither(&groupBox3);
+    form3.addRow("Scale", &scale);
+    form3.addRow("Dither", &dither);
+    groupBox3.setLayout(&form3);
+    l->addWidget(&groupBox3, 4, 3);
+
     if (dialog.exec()) {
         QStringList fileNames = dialog.selectedFiles();
+        // The filters line up with formats, apart from SigMF which is float
+        auto filterIndex = dialog.nameFilters().indexOf(dialog.selectedNameFilter());
+        auto format = (filterIndex >= 0 && filterIndex < (int)formats.size()) ? formats[filterIndex] : ExportFormat::Float32;
 
         size_t start, end;
         if (cursorSelection.isChecked()) {
-            start = selectedSamples.minimum;
-            end = start + selectedSamples.length();
+            auto selection = decimated(selectedSamples, sourceDecimation);
+            start = selection.minimum;
+            end = std::min(start + selection.length(), sampleSrc->count());
         } else if(currentView.isChecked()) {
-            start = viewRange.minimum;
-            end = start + viewRange.length();
+            auto view = decimated(viewRange, sourceDecimation);
+            start = view.minimum;
+            end = std::min(start + view.length(), sampleSrc->count());
         } else {
             start = 0;
             end = sampleSrc->count();
         }
 
-        std::ofstream os (fileNames[0].toStdString(), std::ios::binary);
-
-        size_t index;
-        // viewRange.length() is used as some less arbitrary step value
-        size_t step = viewRange.length();
-
-        QProgressDialog progress("Exporting samples...", "Cancel", start, end, this);
-        progress.setWindowModality(Qt::WindowModal);
-        for (index = start; index < end; index += step) {
-            progress.setValue(index);
-            if (progress.wasCanceled())
-                break;
-
-            size_t length = std::min(step, end - index);
-            auto samples = sampleSrc->getSamples(index, length);
-            if (samples != nullptr) {
-                for (auto i = 0; i < length; i += decimation.value()) {
-                    os.write((const char*)&samples[i], sizeof(SOURCETYPE));
-                }
-            }
+        std::shared_ptr<SampleExporter<SOURCETYPE>> exporter;
+        try {
+            exporter = std::make_shared<SampleExporter<SOURCETYPE>>(
+                std::vector<std::shared_ptr<SampleSource<SOURCETYPE>>>{ sampleSrc },
+                fileNames[0].toStdString(), start, end, decimation.value()
+            );
+            exporter->setFormat(format, scale.value(), dither.isChecked());
+            exporter->writeMetaData();
+        } catch (const std::exception &e) {
+            QMessageBox::critical(this, "Export failed", QString::fromStdString(e.what()));
+            return;
         }
+        exporter->start();
+
+        // The export runs in the background, so keep the UI responsive and
+        // just poll for progress
+        auto progress = new QProgressDialog("Exporting samples...", "Cancel", 0, 1000, this);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->setMinimumDuration(500);
+        auto timer = new QTimer(progress);
+        connect(progress, &QProgressDialog::canceled, [exporter]() {
+            exporter->cancel();
+        });
+        connect(timer, &QTimer::timeout, [this, exporter, progress, timer]() {
+            if (exporter->total() > 0)
+                progress->setValue(1000 * exporter->progress() / exporter->total());
+            if (!exporter->finished())
+                return;
+
+            timer->stop();
+            auto error = exporter->error();
+            progress->close();
+            if (!error.empty())
+                QMessageBox::critical(this, "Export failed", QString::fromStdString(error));
+        });
+        timer->start(100);
     }
 }
 
-void PlotView::invalidateEvent()
+void PlotView::invalidateEvent(const Invalidation &invalidation)
 {
+    // Samples appended to a followed file
+    if (invalidation.type == Invalidation::Samples) {
+        updateView();
+        if (autoScrollEnabled)
+            horizontalScrollBar()->setValue(horizontalScrollBar()->maximum());
+        return;
+    }
+
+    updateChannelPlots();
     horizontalScrollBar()->setMinimum(0);
     horizontalScrollBar()->setMaximum(sampleToColumn(mainSampleSource->count()));
 }
 
+void PlotView::updateChannelPlots()
+{
+    int count = std::max(1, mainSampleSource->channelCount());
+    if (count == channelCount)
+        return;
+    channelCount = count;
+
+    for (auto plot : channelPlots) {
+        plots.erase(std::find_if(plots.begin(), plots.end(), [=](const std::unique_ptr<Plot> &p) {
+            return p.get() == plot;
+        }));
+    }
+    channelPlots.clear();
+
+    for (int channel = 1; channel < count; channel++) {
+        auto plot = new SpectrogramPlot(std::make_shared<InputChannel>(mainSampleSource, channel));
+        plot->setFFTSize(fftSize);
+        plot->setZoomLevel(zoomLevel);
+        plot->setPowerMin(powerMin);
+        plot->setPowerMax(powerMax);
+        plot->setSampleRate(sampleRate);
+        plot->enableScales(timeScaleEnabled);
+        plots.emplace(plots.begin() + channel, plot);
+        connect(plot, &Plot::repaint, this, &PlotView::repaint);
+        channelPlots.push_back(plot);
+    }
+    updateView();
+}
+
+std::vector<SpectrogramPlot*> PlotView::spectrograms()
+{
+    std::vector<SpectrogramPlot*> result;
+    if (spectrogramPlot != nullptr)
+        result.push_back(spectrogramPlot);
+    result.insert(result.end(), channelPlots.begin(), channelPlots.end());
+    return result;
+}
+
 void PlotView::repaint()
 {
     viewport()->update();
@@ -457,13 +601,13 @@ void PlotView::setFFTAndZoom(int size, int zoom)
 
     // Set new FFT size
     fftSize = size;
-    if (spectrogramPlot != nullptr)
-        spectrogramPlot->setFFTSize(size);
+    for (auto plot : spectrograms())
+        plot->setFFTSize(size);
 
     // Set new zoom level
     zoomLevel = zoom;
-    if (spectrogramPlot != nullptr)
-        spectrogramPlot->setZoomLevel(zoom);
+    for (auto plot : spectrograms())
+        plot->setZoomLevel(zoom);
 
     // Update horizontal (time) scrollbar
     horizontalScrollBar()->setSingleStep(10);
@@ -475,16 +619,16 @@ void PlotView::setFFTAndZoom(int size, int zoom)
 void PlotView::setPowerMin(int power)
 {
     powerMin = power;
-    if (spectrogramPlot != nullptr)
-        spectrogramPlot->setPowerMin(power);
+    for (auto plot : spectrograms())
+        plot->setPowerMin(power);
     updateView();
 }
 
 void PlotView::setPowerMax(int power)
 {
     powerMax = power;
-    if (spectrogramPlot != nullptr)
-        spectrogramPlot->setPowerMax(power);
+    for (auto plot : spectrograms())
+        plot->setPowerMax(power);
     updateView();
 }
 
@@ -492,6 +636,8 @@ void PlotView::paintEvent(QPaintEvent *event)
 {
     if (mainSampleSource == nullptr) return;
 
+    TraceScope trace("PlotView::paintEvent");
+    auto paintStart = PerfStats::now();
     QRect rect = QRect(0, 0, width(), height());
     QPainter painter(viewport());
     painter.fillRect(rect, Qt::black);
@@ -502,7 +648,8 @@ void PlotView::paintEvent(QPaintEvent *event)
         int y = -verticalScrollBar()->value();                                  \
         for (auto&& plot : plots) {                                             \
             QRect rect = QRect(0, y, width(), plot->height());                  \
-            plot->paintFunc(painter, rect, viewRange);                          \
+            auto range = decimated(viewRange, plot->decimation());              \
+            plot->paintFunc(painter, rect, range);                              \
             y += plot->height();                                                \
         }                                                                       \
     }
@@ -517,6 +664,10 @@ void PlotView::paintEvent(QPaintEvent *event)
         paintTimeScale(painter, rect, viewRange);
     }
 
+    perfHud.frameFinished(PerfStats::now() - paintStart);
+    if (perfHudEnabled)
+        perfHud.paint(painter, rect);
+
 
 #undef PLOT_LAYER
 }
@@ -607,8 +758,17 @@ void PlotView::updateViewRange(bool reCenter)
 {
     // Update current view
     auto start = columnToSample(horizontalScrollBar()->value());
+    auto oldRange = viewRange;
     viewRange = {start, std::min(start + columnToSample(width()), mainSampleSource->count())};
 
+    // Have the file read ahead one screen in the direction of scrolling,
+    // so the reads overlap with drawing this one
+    size_t length = viewRange.length();
+    if (viewRange.minimum < oldRange.minimum)
+        mainSampleSource->prefetch(viewRange.minimum - std::min(viewRange.minimum, length), 2 * length);
+    else
+        mainSampleSource->prefetch(viewRange.minimum, 2 * length);
+
     // Adjust time offset to zoom around central sample
     if (reCenter) {
         horizontalScrollBar()->setValue(
@@ -645,8 +805,8 @@ void PlotView::setSampleRate(double rate)
 {
     sampleRate = rate;
 
-    if (spectrogramPlot != nullptr)
-        spectrogramPlot->setSampleRate(rate);
+    for (auto plot : spectrograms())
+        plot->setSampleRate(rate);
 
     emitTimeSelection();
 }
@@ -655,8 +815,8 @@ void PlotView::enableScales(bool enabled)
 {
     timeScaleEnabled = enabled;
 
-    if (spectrogramPlot != nullptr)
-        spectrogramPlot->enableScales(enabled);
+    for (auto plot : spectrograms())
+        plot->enableScales(enabled);
 
     viewport()->update();
 }
@@ -676,6 +836,22 @@ void PlotView::enableAnnotationCommentsTooltips(bool enabled)
     viewport()->update();
 }
 
+void PlotView::enablePerfHud(bool enabled)
+{
+    perfHudEnabled = enabled;
+    if (enabled)
+        perfHudTimer->start(500);
+    else
+        perfHudTimer->stop();
+
+    viewport()->update();
+}
+
+void PlotView::enableAutoScroll(bool enabled)
+{
+    autoScrollEnabled = enabled;
+}
+
 int PlotView::sampleToColumn(size_t sample)
 {
     return sample / samplesPerColumn();
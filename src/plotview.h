@@ -21,9 +21,11 @@
 
 #include <QGraphicsView>
 #include <QPaintEvent>
+#include <QTimer>
 
 #include "cursors.h"
 #include "inputsource.h"
+#include "perfhud.h"
 #include "plot.h"
 #include "samplesource.h"
 #include "spectrogramplot.h"
@@ -35,7 +37,9 @@ class PlotView : public QGraphicsView, Subscriber
 
 public:
     PlotView(InputSource *input);
+    void addPlot(Plot *plot);
     void setSampleRate(double rate);
+    SpectrogramPlot *spectrogram() { return spectrogramPlot; };
 
 signals:
     void timeSelectionChanged(float time);
@@ -48,7 +52,9 @@ public slots:
     void enableScales(bool enabled);
     void enableAnnotations(bool enabled);
     void enableAnnotationCommentsTooltips(bool enabled);
-    void invalidateEvent() override;
+    void enablePerfHud(bool enabled);
+    void enableAutoScroll(bool enabled);
+    void invalidateEvent(const Invalidation &invalidation) override;
     void repaint();
     void setCursorSegments(int segments);
     void setFFTAndZoom(int fftSize, int zoomLevel);
@@ -67,8 +73,12 @@ protected:
 
 private:
     Cursors cursors;
-    SampleSource<std::complex<float>> *mainSampleSource = nullptr;
+    InputSource *mainSampleSource = nullptr;
     SpectrogramPlot *spectrogramPlot = nullptr;
+    // Spectrograms of the other channels of a multi-channel recording,
+    // stacked under spectrogramPlot
+    std::vector<SpectrogramPlot*> channelPlots;
+    int channelCount = 1;
     std::vector<std::unique_ptr<Plot>> plots;
     range_t<size_t> viewRange;
     range_t<size_t> selectedSamples;
@@ -84,18 +94,24 @@ private:
     bool timeScaleEnabled;
     int scrollZoomStepsAccumulated = 0;
     bool annotationCommentsEnabled;
+    bool perfHudEnabled = false;
+    bool autoScrollEnabled = true;
+    PerfHud perfHud;
+    QTimer *perfHudTimer;
 
-    void addPlot(Plot *plot);
     void emitTimeSelection();
-    void extractSymbols(std::shared_ptr<AbstractSampleSource> src, bool toClipboard);
-    void exportSamples(std::shared_ptr<AbstractSampleSource> src);
-    template<typename SOURCETYPE> void exportSamples(std::shared_ptr<AbstractSampleSource> src);
+    void extractSymbols(std::shared_ptr<AbstractSampleSource> src, int decimation, bool toClipboard);
+    void exportSamples(std::shared_ptr<AbstractSampleSource> src, int decimation);
+    template<typename SOURCETYPE> void exportSamples(std::shared_ptr<AbstractSampleSource> src, int decimation);
+    void addChannelPlots(std::shared_ptr<AbstractSampleSource> src, int decimation, int channels);
     int plotsHeight();
     size_t samplesPerColumn();
     void updateViewRange(bool reCenter);
     void updateView(bool reCenter = false, bool expanding = false);
     void paintTimeScale(QPainter &painter, QRect &rect, range_t<size_t> sampleRange);
     void updateAnnotationTooltip(QMouseEvent *event);
+    void updateChannelPlots();
+    std::vector<SpectrogramPlot*> spectrograms();
 
     int sampleToColumn(size_t sample);
     size_t columnToSample(int col);
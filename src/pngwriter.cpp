@@ -0,0 +1,132 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pngwriter.h"
+#include <stdexcept>
+#include <string.h>
+
+static void putBigEndian(uint8_t *p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+PngWriter::PngWriter(const std::string &filename, int width, int height)
+    : os(filename, std::ios::binary), width(width), height(height), row(1 + width * 3), compressed(65536)
+{
+    if (!os)
+        throw std::runtime_error("Error opening " + filename + " for writing");
+    if (width <= 0 || height <= 0)
+        throw std::runtime_error("Image is empty");
+
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+        throw std::runtime_error("Error initialising zlib");
+
+    const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    os.write((const char*)signature, sizeof(signature));
+
+    // 8-bit RGB, default compression and filtering, not interlaced
+    uint8_t header[13] = { 0 };
+    putBigEndian(&header[0], width);
+    putBigEndian(&header[4], height);
+    header[8] = 8;
+    header[9] = 2;
+    writeChunk("IHDR", header, sizeof(header));
+}
+
+PngWriter::~PngWriter()
+{
+    deflateEnd(&stream);
+}
+
+void PngWriter::writeRow(const uint32_t *pixels)
+{
+    if (rows >= height)
+        throw std::runtime_error("Too many rows written to PNG");
+
+    // Sub filter: each byte is stored as the difference from the same
+    // channel of the pixel to its left, which suits smooth spectrograms
+    row[0] = 1;
+    uint8_t *p = &row[1];
+    uint32_t previous = 0;
+    for (int x = 0; x < width; x++) {
+        uint32_t pixel = pixels[x];
+        *p++ = ((pixel >> 16) - (previous >> 16)) & 0xff;
+        *p++ = ((pixel >> 8) - (previous >> 8)) & 0xff;
+        *p++ = (pixel - previous) & 0xff;
+        previous = pixel;
+    }
+
+    stream.next_in = row.data();
+    stream.avail_in = row.size();
+    compress(Z_NO_FLUSH);
+    rows++;
+}
+
+void PngWriter::finish()
+{
+    if (rows != height)
+        throw std::runtime_error("Wrong number of rows written to PNG");
+
+    stream.next_in = nullptr;
+    stream.avail_in = 0;
+    compress(Z_FINISH);
+    writeChunk("IEND", nullptr, 0);
+    os.close();
+    if (!os)
+        throw std::runtime_error("Error writing PNG");
+}
+
+void PngWriter::compress(int flush)
+{
+    // Emit an IDAT chunk each time the output buffer fills
+    while (true) {
+        stream.next_out = compressed.data();
+        stream.avail_out = compressed.size();
+        int ret = deflate(&stream, flush);
+        if (ret == Z_STREAM_ERROR)
+            throw std::runtime_error("Error compressing PNG");
+        size_t length = compressed.size() - stream.avail_out;
+        if (length > 0)
+            writeChunk("IDAT", compressed.data(), length);
+        if (flush == Z_FINISH ? ret == Z_STREAM_END : stream.avail_out > 0)
+            break;
+    }
+}
+
+void PngWriter::writeChunk(const char *type, const uint8_t *data, size_t length)
+{
+    uint8_t header[8];
+    putBigEndian(&header[0], length);
+    memcpy(&header[4], type, 4);
+    uLong crc = crc32(0, &header[4], 4);
+    if (length > 0)
+        crc = crc32(crc, data, length);
+    uint8_t footer[4];
+    putBigEndian(footer, crc);
+
+    os.write((const char*)header, sizeof(header));
+    os.write((const char*)data, length);
+    os.write((const char*)footer, sizeof(footer));
+    if (!os)
+        throw std::runtime_error("Error writing PNG");
+}
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+/*
+ * Writes an 8-bit RGB PNG a row at a time, compressing as it goes, so
+ * images far bigger than memory can be written.
+ */
+class PngWriter
+{
+public:
+    PngWriter(const std::string &filename, int width, int height);
+    ~PngWriter();
+    // width pixels as 0xAARRGGBB; alpha is ignored
+    void writeRow(const uint32_t *pixels);
+    // Call once all rows are written
+    void finish();
+
+private:
+    std::ofstream os;
+    int width;
+    int height;
+    int rows = 0;
+    z_stream stream;
+    std::vector<uint8_t> row;
+    std::vector<uint8_t> compressed;
+
+    void compress(int flush);
+    void writeChunk(const char *type, const uint8_t *data, size_t length);
+};
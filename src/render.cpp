@@ -0,0 +1,263 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "inputsource.h"
+#include "pngwriter.h"
+#include "spectrogramengine.h"
+
+/*
+ * Renders a spectrogram to a PNG without a display.
+ *
+ * The image is a waterfall: time runs down the image, one row per FFT
+ * line, and frequency increases to the right. This lets rows be written
+ * as soon as their tile is done, so memory use doesn't depend on the
+ * length of the capture. Tiles are computed on all cores, each thread with
+ * its own SpectrogramEngine, and written in order.
+ */
+
+struct RenderSettings {
+    int fftSize = 512;
+    int zoomLevel = 1;
+    float powerMax = 0.0f;
+    float powerMin = -50.0f;
+    size_t start = 0;
+    size_t length = 0;
+    unsigned threads = 1;
+};
+
+static void render(std::shared_ptr<InputSource> input, const RenderSettings &settings, const std::string &filename)
+{
+    SpectrogramEngine layout(input);
+    layout.setFFTSize(settings.fftSize);
+    layout.setZoomLevel(settings.zoomLevel);
+    const size_t stride = layout.getStride();
+    const size_t linesPerTile = layout.linesPerTile();
+    const size_t lines = (settings.length + stride - 1) / stride;
+    const size_t tiles = (lines + linesPerTile - 1) / linesPerTile;
+
+    // Real signals are symmetric, so only show the positive half
+    const int width = input->realSignal() ? settings.fftSize / 2 : settings.fftSize;
+    const int firstBin = settings.fftSize - width;
+
+    PngWriter png(filename, width, lines);
+
+    std::mutex mutex;
+    std::condition_variable tileDone;
+    std::condition_variable tileWritten;
+    std::map<size_t, std::vector<uint32_t>> pending;
+    size_t nextTile = 0;
+    size_t nextWrite = 0;
+    bool stopped = false;
+    const size_t maxInFlight = settings.threads * 2;
+
+    auto worker = [&]() {
+        SpectrogramEngine engine(input);
+        engine.setFFTSize(settings.fftSize);
+        engine.setZoomLevel(settings.zoomLevel);
+        engine.setPowerMax(settings.powerMax);
+        engine.setPowerMin(settings.powerMin);
+        std::vector<float> fftTile(SpectrogramEngine::tileSize);
+
+        while (true) {
+            size_t tile;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                tileWritten.wait(lock, [&]() {
+                    return stopped || nextTile >= tiles || nextTile < nextWrite + maxInFlight;
+                });
+                if (stopped || nextTile >= tiles)
+                    break;
+                tile = nextTile++;
+            }
+
+            engine.getFFTTile(fftTile.data(), settings.start + tile * linesPerTile * stride);
+            size_t rows = std::min(linesPerTile, lines - tile * linesPerTile);
+            std::vector<uint32_t> pixels(rows * width);
+            for (size_t y = 0; y < rows; y++) {
+                const float *line = &fftTile[y * settings.fftSize + firstBin];
+                uint32_t *row = &pixels[y * width];
+                for (int x = 0; x < width; x++) {
+                    row[x] = engine.colour(line[x]);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending[tile] = std::move(pixels);
+            }
+            tileDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < settings.threads; i++) {
+        threads.emplace_back(worker);
+    }
+
+    auto stop = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        tileWritten.notify_all();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    };
+
+    try {
+        while (nextWrite < tiles) {
+            std::vector<uint32_t> pixels;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                tileDone.wait(lock, [&]() { return pending.count(nextWrite) > 0; });
+                pixels = std::move(pending[nextWrite]);
+                pending.erase(nextWrite);
+            }
+            for (size_t y = 0; y < pixels.size() / width; y++) {
+                png.writeRow(&pixels[y * width]);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                nextWrite++;
+            }
+            tileWritten.notify_all();
+        }
+        png.finish();
+    } catch (...) {
+        stop();
+        throw;
+    }
+    stop();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("inspectrum-render");
+    a.setOrganizationName("inspectrum");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render a spectrogram to a PNG, with time running down the image");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", QCoreApplication::translate("main", "File to render."));
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "PNG file to write."));
+
+    QCommandLineOption formatOption(QStringList() << "f" << "format",
+                                  QCoreApplication::translate("main", "Set file format, as for inspectrum."),
+                                  QCoreApplication::translate("main", "fmt"));
+    parser.addOption(formatOption);
+    QCommandLineOption fftSizeOption(QStringList() << "fft-size",
+                                  QCoreApplication::translate("main", "FFT size, a power of 2 from 16 to 65536 (default 512)."),
+                                  QCoreApplication::translate("main", "size"), "512");
+    parser.addOption(fftSizeOption);
+    QCommandLineOption zoomOption(QStringList() << "zoom",
+                                  QCoreApplication::translate("main", "Lines per FFT length, a power of 2 up to the FFT size (default 1)."),
+                                  QCoreApplication::translate("main", "zoom"), "1");
+    parser.addOption(zoomOption);
+    QCommandLineOption powerMaxOption(QStringList() << "power-max",
+                                  QCoreApplication::translate("main", "Power at the top of the colour scale (default 0)."),
+                                  QCoreApplication::translate("main", "dB"), "0");
+    parser.addOption(powerMaxOption);
+    QCommandLineOption powerMinOption(QStringList() << "power-min",
+                                  QCoreApplication::translate("main", "Power at the bottom of the colour scale (default -50)."),
+                                  QCoreApplication::translate("main", "dB"), "-50");
+    parser.addOption(powerMinOption);
+    QCommandLineOption startOption(QStringList() << "start",
+                                  QCoreApplication::translate("main", "First sample to render (default 0)."),
+                                  QCoreApplication::translate("main", "sample"), "0");
+    parser.addOption(startOption);
+    QCommandLineOption lengthOption(QStringList() << "length",
+                                  QCoreApplication::translate("main", "Number of samples to render (default to the end of the file)."),
+                                  QCoreApplication::translate("main", "samples"));
+    parser.addOption(lengthOption);
+    QCommandLineOption threadsOption(QStringList() << "threads",
+                                  QCoreApplication::translate("main", "Number of threads (default all cores)."),
+                                  QCoreApplication::translate("main", "n"));
+    parser.addOption(threadsOption);
+
+    parser.process(a);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2)
+        parser.showHelp(1);
+
+    auto parse = [&](const QCommandLineOption &option, const char *name) {
+        bool ok;
+        auto value = parser.value(option).toDouble(&ok);
+        if (!ok) {
+            fprintf(stderr, "ERROR: could not parse %s\n", name);
+            exit(1);
+        }
+        return value;
+    };
+
+    RenderSettings settings;
+    settings.fftSize = parse(fftSizeOption, "fft-size");
+    settings.zoomLevel = parse(zoomOption, "zoom");
+    settings.powerMax = parse(powerMaxOption, "power-max");
+    settings.powerMin = parse(powerMinOption, "power-min");
+    settings.start = parse(startOption, "start");
+    settings.threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (parser.isSet(threadsOption))
+        settings.threads = std::max((int)parse(threadsOption, "threads"), 1);
+
+    auto isPowerOf2 = [](int n) { return n > 0 && (n & (n - 1)) == 0; };
+    if (!isPowerOf2(settings.fftSize) || settings.fftSize < 16 || settings.fftSize > SpectrogramEngine::tileSize) {
+        fputs("ERROR: fft-size must be a power of 2 from 16 to 65536\n", stderr);
+        return 1;
+    }
+    if (!isPowerOf2(settings.zoomLevel) || settings.zoomLevel > settings.fftSize) {
+        fputs("ERROR: zoom must be a power of 2 no larger than the FFT size\n", stderr);
+        return 1;
+    }
+
+    auto input = std::make_shared<InputSource>();
+    if (parser.isSet(formatOption))
+        input->setFormat(parser.value(formatOption).toStdString());
+
+    try {
+        input->openFile(args.at(0).toUtf8().constData());
+
+        if (settings.start >= input->count())
+            throw std::runtime_error("Start is past the end of the file");
+        settings.length = input->count() - settings.start;
+        if (parser.isSet(lengthOption))
+            settings.length = std::min((size_t)parse(lengthOption, "length"), settings.length);
+        if (settings.length == 0)
+            throw std::runtime_error("Nothing to render");
+
+        render(input, settings, args.at(1).toStdString());
+    } catch (const std::exception &e) {
+        fprintf(stderr, "ERROR: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
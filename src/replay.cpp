@@ -0,0 +1,425 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QPixmapCache>
+#include <QScrollBar>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <stdio.h>
+#include <vector>
+#include "plots.h"
+#include "plotview.h"
+#include "tracing.h"
+
+/*
+ * Replays a script of user interactions against a PlotView, under the
+ * offscreen platform so it runs without a display, and reports how long
+ * each frame took to paint and how long each interaction took to reach
+ * its final frame, including tiles drawn on background threads.
+ *
+ * Each line of a script is one of:
+ *
+ *   scroll <columns>         scroll right (or left if negative)
+ *   fft <size> <zoom>        change FFT size and zoom, as the sliders do
+ *   power <min> <max>        change the power limits, in dB
+ *   plot <type>              add a sample, amplitude, frequency or phase
+ *                            plot of the tuner output, enabling the tuner
+ *   tuner <pixels>           drag the tuner's centre down (or up)
+ *   repeat <n>               run the next line n times
+ *
+ * Blank lines and lines starting with # are ignored.
+ */
+
+static const char *defaultScript = R"(
+# Scroll through the file
+repeat 50
+scroll 20
+# Change FFT size and zoom
+fft 256 1
+fft 2048 4
+fft 1024 1
+# Drag the tuner while a demodulated trace is shown
+plot frequency
+repeat 20
+tuner 4
+repeat 20
+tuner -4
+# Scroll back with the trace shown
+repeat 30
+scroll -20
+# Adjust the colour scale
+power -90 0
+power -60 -10
+power -100 0
+)";
+
+using Clock = std::chrono::steady_clock;
+
+static double milliseconds(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// PlotView that records how long each paint takes
+class ReplayView : public PlotView
+{
+public:
+    ReplayView(InputSource *input) : PlotView(input) { };
+
+    std::vector<double> paintTimes;
+    Clock::time_point lastPaint;
+
+protected:
+    void paintEvent(QPaintEvent *event) override {
+        auto start = Clock::now();
+        PlotView::paintEvent(event);
+        lastPaint = Clock::now();
+        paintTimes.push_back(milliseconds(lastPaint - start));
+    }
+};
+
+// Process events until nothing is left to paint: no background tiles are
+// being drawn and a couple of passes of the event loop produce no frames
+static void settle(ReplayView &view)
+{
+    auto pool = QThreadPool::globalInstance();
+    int quietPasses = 0;
+    while (quietPasses < 2) {
+        auto frames = view.paintTimes.size();
+        QCoreApplication::sendPostedEvents();
+        QCoreApplication::processEvents();
+        if (pool->activeThreadCount() > 0) {
+            pool->waitForDone();
+            quietPasses = 0;
+        } else if (view.paintTimes.size() != frames) {
+            quietPasses = 0;
+        } else {
+            quietPasses++;
+        }
+    }
+}
+
+static void dragTuner(ReplayView &view, int pixels)
+{
+    auto spectrogram = view.spectrogram();
+    if (!spectrogram->tunerEnabled())
+        throw std::runtime_error("The tuner is only shown once a plot of its output is added with 'plot'");
+
+    // The spectrogram is the top plot
+    QPoint from(view.viewport()->width() / 2, spectrogram->tunerCentre() - view.verticalScrollBar()->value());
+    QPoint to = from + QPoint(0, pixels);
+
+    QMouseEvent press(QEvent::MouseButtonPress, from, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QMouseEvent move(QEvent::MouseMove, to, Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+    QMouseEvent release(QEvent::MouseButtonRelease, to, Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(view.viewport(), &press);
+    QCoreApplication::sendEvent(view.viewport(), &move);
+    QCoreApplication::sendEvent(view.viewport(), &release);
+}
+
+static void addPlot(ReplayView &view, const QString &type)
+{
+    auto src = view.spectrogram()->output();
+    auto compatiblePlots = as_range(Plots::plots.equal_range(src->sampleType()));
+    for (auto p : compatiblePlots) {
+        if (p.second.name == type + " plot") {
+            view.addPlot(p.second.creator(src));
+            view.viewport()->update();
+            return;
+        }
+    }
+    throw std::runtime_error("Unknown plot type " + type.toStdString());
+}
+
+static void runCommand(ReplayView &view, const QStringList &words)
+{
+    auto command = words[0];
+    std::vector<int> args;
+    for (int i = 1; i < words.size(); i++) {
+        bool ok;
+        args.push_back(words[i].toInt(&ok));
+        if (!ok && command != "plot")
+            throw std::runtime_error("Could not parse " + words[i].toStdString());
+    }
+    auto expect = [&](size_t count) {
+        if (args.size() != count)
+            throw std::runtime_error(command.toStdString() + " takes " + std::to_string(count) + " arguments");
+    };
+
+    if (command == "scroll") {
+        expect(1);
+        auto scrollBar = view.horizontalScrollBar();
+        scrollBar->setValue(scrollBar->value() + args[0]);
+    } else if (command == "fft") {
+        expect(2);
+        auto isPowerOf2 = [](int n) { return n > 0 && (n & (n - 1)) == 0; };
+        if (!isPowerOf2(args[0]) || !isPowerOf2(args[1]) || args[1] > args[0])
+            throw std::runtime_error("FFT size and zoom must be powers of 2, with zoom no larger than the FFT size");
+        view.setFFTAndZoom(args[0], args[1]);
+    } else if (command == "power") {
+        expect(2);
+        view.setPowerMin(args[0]);
+        view.setPowerMax(args[1]);
+    } else if (command == "plot") {
+        expect(1);
+        addPlot(view, words[1]);
+    } else if (command == "tuner") {
+        expect(1);
+        dragTuner(view, args[0]);
+    } else {
+        throw std::runtime_error("Unknown command " + command.toStdString());
+    }
+}
+
+// Nearest-rank percentile
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    size_t rank = std::ceil(p / 100 * values.size());
+    return values[std::max(rank, (size_t)1) - 1];
+}
+
+static QJsonObject summary(const std::vector<double> &values)
+{
+    QJsonObject object;
+    object["count"] = (int)values.size();
+    object["p50"] = percentile(values, 50);
+    object["p99"] = percentile(values, 99);
+    object["max"] = values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+    return object;
+}
+
+static QJsonObject replay(ReplayView &view, const QString &script)
+{
+    QJsonArray steps;
+    std::vector<double> paintTimes;
+    std::vector<double> completeTimes;
+
+    settle(view);
+
+    auto lines = script.split('\n');
+    int repeat = 1;
+    for (int n = 0; n < lines.size(); n++) {
+        auto line = lines[n].simplified();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        auto words = line.split(' ');
+
+        try {
+            if (words[0] == "repeat") {
+                bool ok = false;
+                repeat = words.size() == 2 ? words[1].toInt(&ok) : 0;
+                if (!ok || repeat < 1)
+                    throw std::runtime_error("repeat takes a positive count");
+                continue;
+            }
+
+            for (int i = 0; i < repeat; i++) {
+                auto firstFrame = view.paintTimes.size();
+                auto start = Clock::now();
+                view.lastPaint = start;
+                runCommand(view, words);
+                settle(view);
+
+                QJsonArray frames;
+                for (auto j = firstFrame; j < view.paintTimes.size(); j++) {
+                    frames.append(view.paintTimes[j]);
+                    paintTimes.push_back(view.paintTimes[j]);
+                }
+                double complete = milliseconds(view.lastPaint - start);
+                completeTimes.push_back(complete);
+
+                QJsonObject step;
+                step["command"] = line;
+                step["paint_ms"] = frames;
+                step["complete_ms"] = complete;
+                steps.append(step);
+            }
+        } catch (const std::exception &e) {
+            throw std::runtime_error("line " + std::to_string(n + 1) + ": " + e.what());
+        }
+        repeat = 1;
+    }
+
+    QJsonObject result;
+    result["steps"] = steps;
+    result["paint_ms"] = summary(paintTimes);
+    result["complete_ms"] = summary(completeTimes);
+    return result;
+}
+
+// Write a recording of a few tones in noise, for when no file is given
+static void writeSynthetic(QFile &file, size_t length)
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+    std::vector<std::complex<float>> buffer(65536);
+    for (size_t i = 0; i < length;) {
+        size_t n = std::min(buffer.size(), length - i);
+        for (size_t j = 0; j < n; j++, i++) {
+            buffer[j] = 0.5f * std::polar(1.0f, (float)(Tau * fmod(0.1 * i, 1.0)))
+                      + 0.1f * std::polar(1.0f, (float)(Tau * fmod(-0.27 * i + 1e-8 * i * i, 1.0)))
+                      + std::complex<float>(noise(rng), noise(rng));
+        }
+        auto bytes = n * sizeof(buffer[0]);
+        if (file.write(reinterpret_cast<const char*>(buffer.data()), bytes) != (qint64)bytes)
+            throw std::runtime_error("Error writing " + file.fileName().toStdString());
+    }
+    file.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+    a.setApplicationName("inspectrum_replay");
+    a.setOrganizationName("inspectrum");
+
+    // A trace of the replay shows where a slow step's time went
+    Trace::startFromEnvironment();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay a script of interactions and report frame times as JSON");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", QCoreApplication::translate("main", "File to view (default a synthetic recording)."), "[file]");
+
+    QCommandLineOption scriptOption(QStringList() << "script",
+                                  QCoreApplication::translate("main", "Script to replay (default a built-in one)."),
+                                  QCoreApplication::translate("main", "file"));
+    parser.addOption(scriptOption);
+    QCommandLineOption formatOption(QStringList() << "f" << "format",
+                                  QCoreApplication::translate("main", "Set file format, as for inspectrum."),
+                                  QCoreApplication::translate("main", "fmt"));
+    parser.addOption(formatOption);
+    QCommandLineOption rateOption(QStringList() << "r" << "rate",
+                                  QCoreApplication::translate("main", "Set sample rate, if the file doesn't specify it (default 1e6)."),
+                                  QCoreApplication::translate("main", "Hz"));
+    parser.addOption(rateOption);
+    QCommandLineOption widthOption(QStringList() << "width",
+                                  QCoreApplication::translate("main", "View width (default 1280)."),
+                                  QCoreApplication::translate("main", "pixels"), "1280");
+    parser.addOption(widthOption);
+    QCommandLineOption heightOption(QStringList() << "height",
+                                  QCoreApplication::translate("main", "View height (default 800)."),
+                                  QCoreApplication::translate("main", "pixels"), "800");
+    parser.addOption(heightOption);
+    QCommandLineOption lengthOption(QStringList() << "length",
+                                  QCoreApplication::translate("main", "Length of the synthetic recording (default 16M)."),
+                                  QCoreApplication::translate("main", "samples"), "16777216");
+    parser.addOption(lengthOption);
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                  QCoreApplication::translate("main", "Write the report to a file instead of stdout."),
+                                  QCoreApplication::translate("main", "file"));
+    parser.addOption(outputOption);
+
+    parser.process(a);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() > 1)
+        parser.showHelp(1);
+
+    auto parse = [&](const QCommandLineOption &option, const char *name) {
+        bool ok;
+        auto value = parser.value(option).toDouble(&ok);
+        if (!ok) {
+            fprintf(stderr, "ERROR: could not parse %s\n", name);
+            exit(1);
+        }
+        return value;
+    };
+
+    // Same as the GUI
+    QPixmapCache::setCacheLimit(40960);
+
+    try {
+        QString script = defaultScript;
+        if (parser.isSet(scriptOption)) {
+            QFile file(parser.value(scriptOption));
+            if (!file.open(QFile::ReadOnly | QIODevice::Text))
+                throw std::runtime_error("Error opening script: " + file.errorString().toStdString());
+            script = QTextStream(&file).readAll();
+        }
+
+        QTemporaryFile synthetic(QDir::tempPath() + "/inspectrum_replay_XXXXXX.cf32");
+        QString filename;
+        if (args.size() == 1) {
+            filename = args.at(0);
+        } else {
+            if (!synthetic.open())
+                throw std::runtime_error("Error creating " + synthetic.fileName().toStdString());
+            writeSynthetic(synthetic, parse(lengthOption, "length"));
+            filename = synthetic.fileName();
+        }
+
+        // The view takes ownership of the input
+        auto input = new InputSource();
+        ReplayView view(input);
+        if (parser.isSet(formatOption))
+            input->setFormat(parser.value(formatOption).toStdString());
+        input->openFile(filename.toUtf8().constData());
+        if (parser.isSet(rateOption) || input->rate() <= 0)
+            input->setSampleRate(parser.isSet(rateOption) ? parse(rateOption, "rate") : 1e6);
+        view.setSampleRate(input->rate());
+
+        view.resize(parse(widthOption, "width"), parse(heightOption, "height"));
+        view.setFFTAndZoom(1024, 1);
+        view.setPowerMin(-100);
+        view.setPowerMax(0);
+        view.show();
+
+        auto result = replay(view, script);
+        Trace::finish();
+        result["file"] = args.size() == 1 ? filename : QString("synthetic");
+        result["width"] = view.width();
+        result["height"] = view.height();
+        auto json = QJsonDocument(result).toJson();
+
+        if (parser.isSet(outputOption)) {
+            QFile file(parser.value(outputOption));
+            if (!file.open(QFile::WriteOnly) || file.write(json) != json.size())
+                throw std::runtime_error("Error writing report: " + file.errorString().toStdString());
+        } else {
+            fwrite(json.constData(), 1, json.size(), stdout);
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "ERROR: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,366 @@
+/*
+ *  Copyright (C) 2015, Mike Walters <mike@flomp.net>
+ *  Copyright (C) 2015, Jared Boone <jared@sharebrained.com>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <memory>
+#include <stdint.h>
+#include "kernels.h"
+
+/*
+ * Converts samples stored in a file format to complex floats.
+ */
+class SampleAdapter {
+public:
+    // Bytes per sample, or for formats that pack several samples into a
+    // few bytes, per pack of samplesPerPack() samples
+    virtual size_t sampleSize() = 0;
+    virtual size_t samplesPerPack() { return 1; };
+    // start counts samples from src, which must be the start of a pack
+    virtual void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) = 0;
+    virtual ~SampleAdapter() { };
+
+    // Offset of the pack sample is in
+    size_t byteOffset(size_t sample) {
+        return sample / samplesPerPack() * sampleSize();
+    }
+
+    // Samples in whole packs in bytes
+    size_t samplesIn(size_t bytes) {
+        return bytes / sampleSize() * samplesPerPack();
+    }
+};
+
+class ComplexF32SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(std::complex<float>);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const std::complex<float>*>(src);
+        std::copy(&s[start], &s[start + length], dest);
+    }
+};
+
+class ComplexF64SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(std::complex<double>);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const std::complex<double>*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const std::complex<double>& v) -> std::complex<float> {
+                return { static_cast<float>(v.real()) , static_cast<float>(v.imag()) };
+            }
+        );
+    }
+};
+
+class ComplexS32SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(std::complex<int32_t>);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const std::complex<int32_t>*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const std::complex<int32_t>& v) -> std::complex<float> {
+                const float k = 1.0f / 2147483648.0f;
+                return { v.real() * k, v.imag() * k };
+            }
+        );
+    }
+};
+
+class ComplexS16SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(std::complex<int16_t>);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const std::complex<int16_t>*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const std::complex<int16_t>& v) -> std::complex<float> {
+                const float k = 1.0f / 32768.0f;
+                return { v.real() * k, v.imag() * k };
+            }
+        );
+    }
+};
+
+class ComplexS8SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(std::complex<int8_t>);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const std::complex<int8_t>*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const std::complex<int8_t>& v) -> std::complex<float> {
+                const float k = 1.0f / 128.0f;
+                return { v.real() * k, v.imag() * k };
+            }
+        );
+    }
+};
+
+class ComplexS12SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return 3;
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const uint8_t*>(src);
+        kernels::unpack12(&s[start * 3], dest, length, true);
+    }
+};
+
+class ComplexS4SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return 1;
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const uint8_t*>(src);
+        kernels::unpack4(&s[start], dest, length, true);
+    }
+};
+
+class ComplexU8SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(std::complex<uint8_t>);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const std::complex<uint8_t>*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const std::complex<uint8_t>& v) -> std::complex<float> {
+                const float k = 1.0f / 128.0f;
+                return { (v.real() - 127.4f) * k, (v.imag() - 127.4f) * k };
+            }
+        );
+    }
+};
+
+class RealF32SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(float);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const float*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const float& v) -> std::complex<float> {
+                return {v, 0.0f};
+            }
+        );
+    }
+};
+
+class RealF64SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(double);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const double*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const double& v) -> std::complex<float> {
+                return {static_cast<float>(v), 0.0f};
+            }
+        );
+    }
+};
+
+class RealS16SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(int16_t);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const int16_t*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const int16_t& v) -> std::complex<float> {
+                const float k = 1.0f / 32768.0f;
+                return { v * k, 0.0f };
+            }
+        );
+    }
+};
+
+class RealS8SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(int8_t);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const int8_t*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const int8_t& v) -> std::complex<float> {
+                const float k = 1.0f / 128.0f;
+                return { v * k, 0.0f };
+            }
+        );
+    }
+};
+
+class RealU8SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return sizeof(uint8_t);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const uint8_t*>(src);
+        std::transform(&s[start], &s[start + length], dest,
+            [](const uint8_t& v) -> std::complex<float> {
+                const float k = 1.0f / 128.0f;
+                return { (v - 127.4f) * k, 0 };
+            }
+        );
+    }
+};
+
+// Two samples to every three bytes
+class RealS12SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return 3;
+    }
+
+    size_t samplesPerPack() override {
+        return 2;
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const uint8_t*>(src) + start / 2 * 3;
+        auto d = dest;
+        // Starting part way into a pack: its second sample comes first
+        if (start % 2 && length > 0) {
+            std::complex<float> pack[2];
+            kernels::unpack12(s, pack, 2, false);
+            *d++ = pack[1];
+            s += 3;
+            length--;
+        }
+        kernels::unpack12(s, d, length, false);
+    }
+};
+
+// Two samples to every byte
+class RealS4SampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return 1;
+    }
+
+    size_t samplesPerPack() override {
+        return 2;
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const uint8_t*>(src) + start / 2;
+        auto d = dest;
+        if (start % 2 && length > 0) {
+            std::complex<float> pack[2];
+            kernels::unpack4(s, pack, 2, false);
+            *d++ = pack[1];
+            s++;
+            length--;
+        }
+        kernels::unpack4(s, d, length, false);
+    }
+};
+
+// Big-endian versions of the multi-byte formats, which swap bytes as they
+// convert. Integers are scaled to +/-1 like the little-endian ones.
+template<typename T, bool complex>
+class BigEndianSampleAdapter : public SampleAdapter {
+public:
+    size_t sampleSize() override {
+        return complex ? sizeof(T) * 2 : sizeof(T);
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        auto s = reinterpret_cast<const T*>(src);
+        kernels::convertBigEndian(&s[complex ? start * 2 : start], dest, length, complex, scale);
+    }
+
+private:
+    const float scale = std::numeric_limits<T>::is_integer ? 1.0f / ((float)std::numeric_limits<T>::max() + 1.0f) : 1.0f;
+};
+
+using ComplexF32BESampleAdapter = BigEndianSampleAdapter<float, true>;
+using ComplexF64BESampleAdapter = BigEndianSampleAdapter<double, true>;
+using ComplexS32BESampleAdapter = BigEndianSampleAdapter<int32_t, true>;
+using ComplexS16BESampleAdapter = BigEndianSampleAdapter<int16_t, true>;
+using RealF32BESampleAdapter = BigEndianSampleAdapter<float, false>;
+using RealF64BESampleAdapter = BigEndianSampleAdapter<double, false>;
+using RealS16BESampleAdapter = BigEndianSampleAdapter<int16_t, false>;
+
+// One channel of a recording with several channels interleaved sample by
+// sample. The channel's samples are gathered a chunk at a time and then
+// converted as format.
+class InterleavedSampleAdapter : public SampleAdapter {
+public:
+    InterleavedSampleAdapter(std::shared_ptr<SampleAdapter> format, int channels, int channel)
+        : format(std::move(format)), channels(channels), channel(channel) { };
+
+    size_t sampleSize() override {
+        return format->sampleSize() * channels;
+    }
+
+    void copyRange(const void* const src, size_t start, size_t length, std::complex<float>* const dest) override {
+        const size_t size = format->sampleSize();
+        const size_t stride = sampleSize();
+        const size_t chunk = bufferSize / size;
+        auto s = reinterpret_cast<const uint8_t*>(src) + channel * size;
+        alignas(16) uint8_t buffer[bufferSize];
+        for (size_t done = 0; done < length;) {
+            size_t n = std::min(chunk, length - done);
+            kernels::gather(&s[(start + done) * stride], stride, size, buffer, n);
+            format->copyRange(buffer, 0, n, &dest[done]);
+            done += n;
+        }
+    }
+
+private:
+    static const size_t bufferSize = 16384;
+
+    std::shared_ptr<SampleAdapter> format;
+    int channels;
+    int channel;
+};
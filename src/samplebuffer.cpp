@@ -18,12 +18,141 @@
  */
 
 #include <QMutexLocker>
+#include <algorithm>
 #include <string.h>
+#include <vector>
 #include "samplebuffer.h"
+#include "tracing.h"
+
+const size_t AbstractSampleBuffer::chunkSize;
+const size_t AbstractSampleBuffer::noStream;
+const size_t AbstractSampleBuffer::maxStreams;
+
+void AbstractSampleBuffer::resetStreams()
+{
+    streams.clear();
+    generation++;
+}
+
+AbstractSampleBuffer::Stream AbstractSampleBuffer::takeStream(size_t next, size_t &history)
+{
+    QMutexLocker ml(&mutex);
+    for (auto it = streams.begin(); it != streams.end(); it++) {
+        if (it->nextInput == next) {
+            Stream stream = std::move(*it);
+            streams.erase(it);
+            history = 0;
+            return stream;
+        }
+    }
+    history = std::min(next, historyLength());
+    return Stream();
+}
+
+void AbstractSampleBuffer::returnStream(Stream stream)
+{
+    if (stream.nextInput == noStream)
+        return;
+
+    QMutexLocker ml(&mutex);
+    if (stream.generation != generation)
+        return;
+    streams.push_front(std::move(stream));
+    if (streams.size() > maxStreams)
+        streams.pop_back();
+}
+
+void AbstractSampleBuffer::runStream(Stream &stream, void *input, void *output, size_t count, size_t inputStart)
+{
+    QMutexLocker ml(&mutex);
+    if (stream.nextInput != inputStart || stream.generation != generation) {
+        stream.state = createState();
+        stream.generation = generation;
+    }
+    useState(stream.state.get());
+    {
+        TraceScope trace(Trace::enabled() ? Trace::intern(Trace::typeName(typeid(*this)) + "::work") : nullptr);
+        work(input, output, count, inputStart);
+    }
+    useState(nullptr);
+    stream.nextInput = inputStart + count;
+}
+
+bool AbstractSampleBuffer::runChain(size_t start, size_t length, void *dest)
+{
+    // Collect the chain, first stage first
+    std::vector<AbstractSampleBuffer*> stages;
+    for (auto stage = this; stage != nullptr; stage = stage->upstream()) {
+        stages.insert(stages.begin(), stage);
+    }
+
+    size_t maxSize = 0;
+    for (auto stage : stages) {
+        maxSize = std::max({maxSize, stage->inputSize(), stage->outputSize()});
+    }
+    std::vector<char> in;
+    std::vector<char> out;
+
+    // The stream each stage is running, kept from one chunk to the next
+    std::vector<Stream> running(stages.size());
+    auto finish = [&](bool ok) {
+        for (size_t i = 0; i < stages.size(); i++) {
+            stages[i]->returnStream(std::move(running[i]));
+        }
+        return ok;
+    };
+
+    std::vector<size_t> outputStart(stages.size());
+    std::vector<size_t> history(stages.size());
+    for (size_t done = 0; done < length; done += chunkSize) {
+        const size_t end = start + std::min(length, done + chunkSize);
+
+        // A stage with a stream that stopped exactly where this chunk
+        // starts just carries on. Any other stage starts a new stream,
+        // warmed up with the same history nested getSamples calls would
+        // have given it. Streams are taken out while they run, so
+        // parallel runs never continue the same one.
+        size_t first = start + done;
+        for (size_t i = stages.size(); i-- > 0;) {
+            outputStart[i] = first;
+            if (running[i].nextInput == first) {
+                history[i] = 0;
+            } else {
+                stages[i]->returnStream(std::move(running[i]));
+                running[i] = stages[i]->takeStream(first, history[i]);
+            }
+            first -= history[i];
+        }
+
+        // Every later stage's input is a suffix of the first one's
+        in.resize((end - first) * maxSize);
+        out.resize((end - first) * maxSize);
+        bool ok = stages.front()->readInput(first, end - first, in.data());
+
+        char *input = in.data();
+        for (size_t i = 0; ok && i < stages.size(); i++) {
+            auto stage = stages[i];
+            const size_t inputStart = outputStart[i] - history[i];
+            stage->runStream(running[i], input, out.data(), end - inputStart, inputStart);
+
+            // The next stage's input starts at this stage's output start
+            input = out.data() + history[i] * stage->outputSize();
+            std::swap(in, out);
+        }
+
+        if (!ok)
+            return finish(false);
+
+        auto last = stages.back();
+        memcpy((char*)dest + done * last->outputSize(), input, (end - start - done) * last->outputSize());
+    }
+    return finish(true);
+}
 
 template <typename Tin, typename Tout>
 SampleBuffer<Tin, Tout>::SampleBuffer(std::shared_ptr<SampleSource<Tin>> src) : src(src)
 {
+    upstreamBuffer = dynamic_cast<AbstractSampleBuffer*>(src.get());
     src->subscribe(this);
 }
 
@@ -34,26 +163,48 @@ SampleBuffer<Tin, Tout>::~SampleBuffer()
 }
 
 template <typename Tin, typename Tout>
-std::unique_ptr<Tout[]> SampleBuffer<Tin, Tout>::getSamples(size_t start, size_t length)
+bool SampleBuffer<Tin, Tout>::readInput(size_t start, size_t length, void *dest)
 {
-    // TODO: base this on the actual history required
-    auto history = std::min(start, (size_t)256);
-    auto samples = src->getSamples(start - history, length + history);
+    auto samples = src->getSamples(start, length);
     if (samples == nullptr)
-        return nullptr;
+        return false;
+
+    memcpy(dest, samples.get(), length * sizeof(Tin));
+    return true;
+}
 
-    auto temp = std::make_unique<Tout[]>(history + length);
+template <typename Tin, typename Tout>
+std::unique_ptr<Tout[]> SampleBuffer<Tin, Tout>::getSamples(size_t start, size_t length)
+{
     auto dest = std::make_unique<Tout[]>(length);
-    QMutexLocker ml(&mutex);
-    work(samples.get(), temp.get(), history + length, start);
-    memcpy(dest.get(), temp.get() + history, length * sizeof(Tout));
+    if (!runChain(start, length, dest.get()))
+        return nullptr;
     return dest;
 }
 
 template <typename Tin, typename Tout>
-void SampleBuffer<Tin, Tout>::invalidateEvent()
+void SampleBuffer<Tin, Tout>::invalidateEvent(const Invalidation &invalidation)
 {
-    SampleSource<Tout>::invalidate();
+    if (!invalidation.changesSamples()) {
+        SampleSource<Tout>::invalidate(invalidation);
+        return;
+    }
+
+    // State carried over from the old samples is no longer valid, and
+    // each output depends on up to historyLength() earlier inputs
+    size_t history;
+    {
+        QMutexLocker ml(&mutex);
+        resetStreams();
+        history = historyLength();
+    }
+    if (invalidation.type == Invalidation::Samples) {
+        auto end = invalidation.range.maximum;
+        end = end > SIZE_MAX - history ? SIZE_MAX : end + history;
+        SampleSource<Tout>::invalidate(Invalidation::samples(invalidation.range.minimum, end));
+    } else {
+        SampleSource<Tout>::invalidate(invalidation);
+    }
 }
 
 template class SampleBuffer<std::complex<float>, std::complex<float>>;
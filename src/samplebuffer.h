@@ -21,22 +21,121 @@
 
 #include <QMutex>
 #include <complex>
+#include <list>
 #include <memory>
+#include <stdint.h>
 #include "samplesource.h"
 
+/*
+ * Type-erased view of a SampleBuffer, used to run a linear chain of
+ * buffers (e.g. tuner -> demod -> threshold) as one fused loop over
+ * cache-sized chunks instead of one full-length pass per stage.
+ */
+class AbstractSampleBuffer
+{
+public:
+    virtual ~AbstractSampleBuffer() {};
+
+    // Process count samples, where input[0] is sample sampleid of the
+    // input. Stages may keep state (filter, previous sample) between
+    // calls: consecutive calls continue with the state given to
+    // useState(), or the stage's own if none was.
+    virtual void work(void *input, void *output, int count, size_t sampleid) = 0;
+
+protected:
+    // Output samples per chunk of a fused run, small enough that every
+    // stage's input and output stay in L2
+    static const size_t chunkSize = 16384;
+    static const size_t noStream = SIZE_MAX;
+    // Streams to keep state for, e.g. one per tile being drawn at once
+    static const size_t maxStreams = 16;
+
+    // What a stateful stage carries over from one work() call to the next
+    struct State
+    {
+        virtual ~State() {};
+    };
+
+    // Protects the stage's parameters and streams. Only held while the
+    // stage runs, not while the chain's input is read.
+    QMutex mutex;
+
+    // A state as at the start of a stream, or nullptr for stages without
+    // any (called with mutex held)
+    virtual std::unique_ptr<State> createState() { return nullptr; };
+    // Make work() use state, or the stage's own if it's nullptr (called
+    // with mutex held)
+    virtual void useState(State *state) {};
+    // Input samples needed to bring a new state up to the one it would
+    // have had running continuously, none for stages without state (called
+    // with mutex held)
+    virtual size_t historyLength() { return 0; };
+    // Forget every stream, e.g. when a parameter changes (called with
+    // mutex held)
+    void resetStreams();
+
+    // The stage before this one, or nullptr if the input isn't a SampleBuffer
+    virtual AbstractSampleBuffer *upstream() = 0;
+    virtual size_t inputSize() = 0;
+    virtual size_t outputSize() = 0;
+    // Copy [start, start + length) of this stage's input into dest
+    virtual bool readInput(size_t start, size_t length, void *dest) = 0;
+
+    bool runChain(size_t start, size_t length, void *dest);
+
+private:
+    // A run of work() calls, each continuing from where the last stopped.
+    // Several streams, e.g. tiles being drawn or chunks being exported in
+    // parallel, each carry on with their own state.
+    struct Stream
+    {
+        // Input sample following the last one processed, or noStream
+        size_t nextInput = noStream;
+        size_t generation = 0;
+        std::unique_ptr<State> state;
+    };
+
+    // Streams no run is using, most recently used first. Protected by
+    // mutex.
+    std::list<Stream> streams;
+    // Incremented by resetStreams(), so streams taken before then aren't
+    // put back. Protected by mutex.
+    size_t generation = 0;
+
+    // The stream that stopped at input sample next, if there is one,
+    // taken out so no other run can use it. Otherwise history is set to
+    // the warm-up a new stream starting there needs.
+    Stream takeStream(size_t next, size_t &history);
+    void returnStream(Stream stream);
+    // work() over count inputs starting at inputStart, continuing stream
+    // if it stopped there
+    void runStream(Stream &stream, void *input, void *output, size_t count, size_t inputStart);
+};
+
 template <typename Tin, typename Tout>
-class SampleBuffer : public SampleSource<Tout>, public Subscriber
+class SampleBuffer : public SampleSource<Tout>, public AbstractSampleBuffer, public Subscriber
 {
 private:
     std::shared_ptr<SampleSource<Tin>> src;
-    QMutex mutex;
+    AbstractSampleBuffer *upstreamBuffer;
+
+protected:
+    AbstractSampleBuffer *upstream() override {
+        return upstreamBuffer;
+    };
+    size_t inputSize() override {
+        return sizeof(Tin);
+    };
+    size_t outputSize() override {
+        return sizeof(Tout);
+    };
+    bool readInput(size_t start, size_t length, void *dest) override;
 
 public:
     SampleBuffer(std::shared_ptr<SampleSource<Tin>> src);
     ~SampleBuffer();
-    void invalidateEvent();
+    void invalidateEvent(const Invalidation &invalidation);
     virtual std::unique_ptr<Tout[]> getSamples(size_t start, size_t length);
-    virtual void work(void *input, void *output, int count, size_t sampleid) = 0;
     virtual size_t count() {
         return src->count();
     };
@@ -47,4 +146,8 @@ public:
     float relativeBandwidth() {
         return src->relativeBandwidth();
     }
+
+    double getFrequency() {
+        return src->getFrequency();
+    }
 };
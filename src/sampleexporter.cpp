@@ -0,0 +1,341 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sampleexporter.h"
+#include <liquid/liquid.h>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string.h>
+#include <type_traits>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "kernels.h"
+
+template<typename T>
+const size_t SampleExporter<T>::chunkSamples;
+
+template<typename T>
+SampleExporter<T>::SampleExporter(std::vector<std::shared_ptr<SampleSource<T>>> sources, const std::string &filename,
+                                  size_t start, size_t end, int decimation)
+    : sources(sources), filename(filename), os(filename, std::ios::binary), begin(start), end(end), decimation(std::max(decimation, 1)),
+      written(0), cancelled(false), running(0)
+{
+    if (!os)
+        throw std::runtime_error("Error opening " + filename + " for writing");
+
+    // A band-limited source that already fits the new Nyquist frequency,
+    // i.e. the tuner's output, is just decimated. Filtering again would
+    // only cut into its passband and double the cost.
+    auto src = sources.front();
+    bool filtered = src->bandLimited() && src->relativeBandwidth() * this->decimation <= 1.001f;
+    if (this->decimation > 1 && !filtered) {
+        // Anti-alias filter with its stopband starting at the new Nyquist
+        // frequency, 60 dB down
+        auto len = estimate_req_filter_len(0.1f / this->decimation, 60.0f);
+        taps.resize(len);
+        liquid_firdes_kaiser(len, 0.45f / this->decimation, 60.0f, 0.0f, taps.data());
+        float sum = std::accumulate(taps.begin(), taps.end(), 0.0f);
+        for (auto &tap : taps) {
+            tap /= sum;
+        }
+        // Reversed, so the convolution walks forwards through the input
+        std::reverse(taps.begin(), taps.end());
+    }
+
+    chunkLength = std::max(chunkSamples / this->decimation, (size_t)1) * this->decimation;
+    chunkCount = (end - begin + chunkLength - 1) / chunkLength;
+}
+
+template<typename T>
+SampleExporter<T>::~SampleExporter()
+{
+    cancel();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+template<typename T>
+void SampleExporter<T>::setFormat(ExportFormat format, float scale, bool dither)
+{
+    this->format = format;
+    this->scale = scale;
+    this->dither = dither;
+}
+
+template<typename T>
+std::string SampleExporter<T>::datatype()
+{
+    std::string type = std::is_same<T, std::complex<float>>::value ? "c" : "r";
+    switch (format) {
+    case ExportFormat::Float32:
+        return type + "f32_le";
+    case ExportFormat::Int16:
+        return type + "i16_le";
+    case ExportFormat::Int8:
+        return type + "i8";
+    case ExportFormat::Uint8:
+        return type + "u8";
+    }
+    return type;
+}
+
+template<typename T>
+void SampleExporter<T>::writeMetaData()
+{
+    auto src = sources[0];
+
+    // Don't risk overwriting another recording's meta file unless the
+    // output is named as a SigMF recording
+    QFileInfo fileInfo(QString::fromStdString(filename));
+    QString metaFilename = fileInfo.filePath() + ".sigmf-meta";
+    QString dataset = fileInfo.fileName();
+    if (fileInfo.suffix() == "sigmf-data") {
+        metaFilename = fileInfo.path() + "/" + fileInfo.completeBaseName() + ".sigmf-meta";
+        dataset.clear();
+    }
+
+    QJsonObject global;
+    global["core:datatype"] = QString::fromStdString(datatype());
+    global["core:sample_rate"] = src->rate() / decimation;
+    global["core:version"] = "1.0.0";
+    if (!dataset.isEmpty())
+        global["core:dataset"] = dataset;
+
+    QJsonObject capture;
+    capture["core:sample_start"] = 0;
+    capture["core:frequency"] = src->getFrequency();
+
+    QJsonObject meta;
+    meta["global"] = global;
+    meta["captures"] = QJsonArray{ capture };
+    meta["annotations"] = QJsonArray();
+
+    QFile file(metaFilename);
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(meta).toJson()) < 0)
+        throw std::runtime_error("Error writing " + metaFilename.toStdString());
+}
+
+template<typename T>
+void SampleExporter<T>::start()
+{
+    size_t workers = std::max(std::thread::hardware_concurrency(), 1u);
+    workers = std::max(std::min(workers, chunkCount), (size_t)1);
+    maxInFlight = workers * 2;
+
+    running = workers + 1;
+    threads.emplace_back(&SampleExporter::writer, this);
+    for (size_t i = 0; i < workers; i++) {
+        threads.emplace_back(&SampleExporter::worker, this, i);
+    }
+}
+
+template<typename T>
+void SampleExporter<T>::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+    }
+    chunkDone.notify_all();
+    chunkWritten.notify_all();
+}
+
+template<typename T>
+bool SampleExporter<T>::finished()
+{
+    return running == 0;
+}
+
+template<typename T>
+size_t SampleExporter<T>::progress()
+{
+    return written;
+}
+
+template<typename T>
+std::string SampleExporter<T>::error()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return errorMessage;
+}
+
+template<typename T>
+void SampleExporter<T>::fail(const std::string &message)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (errorMessage.empty())
+            errorMessage = message;
+        cancelled = true;
+    }
+    chunkDone.notify_all();
+    chunkWritten.notify_all();
+}
+
+template<typename T>
+void SampleExporter<T>::worker(size_t index)
+{
+    auto src = sources[index % sources.size()].get();
+    while (true) {
+        size_t chunk;
+        {
+            // Don't get too far ahead of the writer
+            std::unique_lock<std::mutex> lock(mutex);
+            chunkWritten.wait(lock, [&]() {
+                return cancelled || nextChunk >= chunkCount || nextChunk < nextWrite + maxInFlight;
+            });
+            if (cancelled || nextChunk >= chunkCount)
+                break;
+            chunk = nextChunk++;
+        }
+
+        std::vector<char> output;
+        if (!processChunk(src, chunk, output)) {
+            fail("Error reading samples");
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending[chunk] = std::move(output);
+        }
+        chunkDone.notify_all();
+    }
+    running--;
+}
+
+template<typename T>
+void SampleExporter<T>::writer()
+{
+    while (nextWrite < chunkCount) {
+        std::vector<char> data;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            chunkDone.wait(lock, [&]() {
+                return cancelled || pending.count(nextWrite) > 0;
+            });
+            if (cancelled)
+                break;
+            data = std::move(pending[nextWrite]);
+            pending.erase(nextWrite);
+        }
+
+        os.write(data.data(), data.size());
+        if (!os) {
+            fail("Error writing samples");
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            nextWrite++;
+        }
+        written = std::min(nextWrite * chunkLength, end - begin);
+        chunkWritten.notify_all();
+    }
+
+    os.close();
+    if (!cancelled && !os)
+        fail("Error writing samples");
+    running--;
+}
+
+template<typename T>
+bool SampleExporter<T>::processChunk(SampleSource<T> *src, size_t chunk, std::vector<char> &output)
+{
+    const size_t first = begin + chunk * chunkLength;
+    const size_t last = std::min(first + chunkLength, end);
+    const size_t outputs = (last - first + decimation - 1) / decimation;
+
+    if (taps.empty()) {
+        auto samples = src->getSamples(first, last - first);
+        if (samples == nullptr)
+            return false;
+        for (size_t j = 1; j < outputs; j++) {
+            samples[j] = samples[j * decimation];
+        }
+        encode(samples.get(), outputs, chunk, output);
+        return true;
+    }
+
+    // Output j is centred on input first + j * decimation, so read half the
+    // filter length either side, zero-padding past the ends of the source
+    const ssize_t len = taps.size();
+    const ssize_t delay = (len - 1) / 2;
+    const ssize_t readStart = (ssize_t)first - (len - 1 - delay);
+    const ssize_t readEnd = (ssize_t)(first + (outputs - 1) * decimation) + delay + 1;
+    auto input = std::make_unique<T[]>(readEnd - readStart);
+    const ssize_t clipStart = std::max(readStart, (ssize_t)0);
+    const ssize_t clipEnd = std::min(readEnd, (ssize_t)src->count());
+    if (clipEnd > clipStart) {
+        auto samples = src->getSamples(clipStart, clipEnd - clipStart);
+        if (samples == nullptr)
+            return false;
+        memcpy(&input[clipStart - readStart], samples.get(), (clipEnd - clipStart) * sizeof(T));
+    }
+
+    auto out = std::make_unique<T[]>(outputs);
+    for (size_t j = 0; j < outputs; j++) {
+        const T *x = &input[j * decimation];
+        T acc = 0;
+        for (ssize_t k = 0; k < len; k++) {
+            acc += taps[k] * x[k];
+        }
+        out[j] = acc;
+    }
+    encode(out.get(), outputs, chunk, output);
+    return true;
+}
+
+template<typename T>
+void SampleExporter<T>::encode(const T *samples, size_t count, size_t chunk, std::vector<char> &output)
+{
+    // Complex samples are quantized as interleaved real and imaginary parts.
+    // Seeding the dither with the chunk number keeps the output identical
+    // however the chunks are spread over threads.
+    auto values = reinterpret_cast<const float*>(samples);
+    const size_t n = count * (sizeof(T) / sizeof(float));
+    switch (format) {
+    case ExportFormat::Float32:
+        output.resize(n * sizeof(float));
+        memcpy(output.data(), values, output.size());
+        break;
+    case ExportFormat::Int16:
+        output.resize(n * sizeof(int16_t));
+        kernels::quantize(values, reinterpret_cast<int16_t*>(output.data()), n, 32768.0f * scale, 0.0f, dither, chunk);
+        break;
+    case ExportFormat::Int8:
+        output.resize(n * sizeof(int8_t));
+        kernels::quantize(values, reinterpret_cast<int8_t*>(output.data()), n, 128.0f * scale, 0.0f, dither, chunk);
+        break;
+    case ExportFormat::Uint8:
+        // Same offset InputSource assumes when reading
+        output.resize(n * sizeof(uint8_t));
+        kernels::quantize(values, reinterpret_cast<uint8_t*>(output.data()), n, 128.0f * scale, 127.4f, dither, chunk);
+        break;
+    }
+}
+
+template class SampleExporter<std::complex<float>>;
+template class SampleExporter<float>;
@@ -0,0 +1,119 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "samplesource.h"
+
+enum class ExportFormat {
+    Float32,
+    Int16,
+    Int8,
+    Uint8,
+};
+
+/*
+ * Writes [start, end) of a source to a file, low-pass filtered and
+ * decimated, on background threads. Sources that are bandLimited() to a
+ * relativeBandwidth() within the decimated rate (only TunerTransform's
+ * output, not stages derived from it such as demodulators) are decimated
+ * without filtering again.
+ *
+ * Worker threads each read, filter and decimate one large chunk at a time,
+ * and a writer thread appends finished chunks to the file in order. The
+ * number of chunks in flight is bounded, so memory use doesn't depend on
+ * the export length.
+ *
+ * Workers take turns over the given sources, so stateful transforms can be
+ * given one instance per worker to run truly in parallel. Passing a single
+ * source is fine too.
+ *
+ * Samples are written as floats by default, or quantized to integers with
+ * setFormat. Complex samples are written as interleaved I/Q.
+ */
+template<typename T>
+class SampleExporter
+{
+public:
+    SampleExporter(std::vector<std::shared_ptr<SampleSource<T>>> sources, const std::string &filename,
+                   size_t start, size_t end, int decimation);
+    ~SampleExporter();
+    // Call before start. Full scale (+/-1.0 in) maps to the integer range,
+    // multiplied by scale.
+    void setFormat(ExportFormat format, float scale, bool dither);
+    // SigMF core:datatype of the output
+    std::string datatype();
+    // Writes a SigMF meta file describing the output. If the output isn't
+    // named .sigmf-data, the meta file is the output name plus
+    // .sigmf-meta, and points at the output as its dataset.
+    void writeMetaData();
+    void start();
+    void cancel();
+    bool finished();
+    // Input samples processed so far
+    size_t progress();
+    size_t total() { return end - begin; };
+    // Empty unless the export failed
+    std::string error();
+
+private:
+    // Input samples per chunk, before decimation
+    static const size_t chunkSamples = 1 << 20;
+
+    std::vector<std::shared_ptr<SampleSource<T>>> sources;
+    std::string filename;
+    std::ofstream os;
+    size_t begin;
+    size_t end;
+    int decimation;
+    std::vector<float> taps;
+    ExportFormat format = ExportFormat::Float32;
+    float scale = 1.0f;
+    bool dither = false;
+    size_t chunkLength;
+    size_t chunkCount;
+    size_t maxInFlight;
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable chunkDone;
+    std::condition_variable chunkWritten;
+    std::map<size_t, std::vector<char>> pending;
+    size_t nextChunk = 0;
+    size_t nextWrite = 0;
+    std::atomic<size_t> written;
+    std::atomic<bool> cancelled;
+    std::atomic<int> running;
+    std::string errorMessage;
+
+    void worker(size_t index);
+    void writer();
+    bool processChunk(SampleSource<T> *src, size_t chunk, std::vector<char> &output);
+    void encode(const T *samples, size_t count, size_t chunk, std::vector<char> &output);
+    void fail(const std::string &message);
+};
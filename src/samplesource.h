@@ -45,18 +45,27 @@ template<typename T>
 class SampleSource : public AbstractSampleSource
 {
 protected:
-    double frequency;
+    double frequency = 0;
 
 public:
     virtual ~SampleSource() {};
 
     virtual std::unique_ptr<T[]> getSamples(size_t start, size_t length) = 0;
-    virtual void invalidateEvent() { };
+    virtual void invalidateEvent(const Invalidation &invalidation) { };
     virtual size_t count() = 0;
     virtual double rate() = 0;
     virtual float relativeBandwidth() = 0;
+    // Whether the samples hold nothing outside relativeBandwidth(), so they
+    // can be decimated to it without filtering. Stages that pass on their
+    // input's bandwidth but aren't linear filters, e.g. demodulators, don't
+    // say so.
+    virtual bool bandLimited() { return false; };
     std::vector<Annotation> annotationList;
     std::type_index sampleType() override;
     virtual bool realSignal() { return false; };
-    double getFrequency();
+    // Centre frequency of the signal in Hz, if known
+    virtual double getFrequency();
+    // Centre frequency of the capture sample is part of, for recordings
+    // whose frequency changes
+    virtual double captureFrequency(size_t sample) { return getFrequency(); };
 };
@@ -0,0 +1,246 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ * Minimal 4-lane float vector used by the kernels in kernels.cpp.
+ *
+ * On x86 this maps onto SSE2, which every x86-64 CPU has, so no runtime
+ * dispatch is needed. Elsewhere (or with INSPECTRUM_NO_SIMD defined) it
+ * falls back to plain arrays, which the compiler is free to vectorize.
+ */
+
+#include <complex>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(INSPECTRUM_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define INSPECTRUM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace simd
+{
+
+#ifdef INSPECTRUM_SSE2
+
+struct v4f {
+    __m128 v;
+};
+
+inline v4f load(const float *p) { return { _mm_loadu_ps(p) }; }
+inline void store(float *p, v4f a) { _mm_storeu_ps(p, a.v); }
+inline v4f set1(float f) { return { _mm_set1_ps(f) }; }
+
+inline v4f operator+(v4f a, v4f b) { return { _mm_add_ps(a.v, b.v) }; }
+inline v4f operator-(v4f a, v4f b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline v4f operator*(v4f a, v4f b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline v4f operator/(v4f a, v4f b) { return { _mm_div_ps(a.v, b.v) }; }
+inline v4f min(v4f a, v4f b) { return { _mm_min_ps(a.v, b.v) }; }
+inline v4f max(v4f a, v4f b) { return { _mm_max_ps(a.v, b.v) }; }
+
+// Comparisons return all-ones lanes where true
+inline v4f greater(v4f a, v4f b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline v4f less(v4f a, v4f b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+
+inline v4f bitAnd(v4f a, v4f b) { return { _mm_and_ps(a.v, b.v) }; }
+inline v4f bitOr(v4f a, v4f b) { return { _mm_or_ps(a.v, b.v) }; }
+inline v4f bitAndNot(v4f a, v4f b) { return { _mm_andnot_ps(a.v, b.v) }; }
+
+struct v4i {
+    __m128i v;
+};
+
+inline v4i set1i(int32_t i) { return { _mm_set1_epi32(i) }; }
+inline v4i seti(int32_t a, int32_t b, int32_t c, int32_t d) { return { _mm_setr_epi32(a, b, c, d) }; }
+inline v4i operator+(v4i a, v4i b) { return { _mm_add_epi32(a.v, b.v) }; }
+inline v4i operator-(v4i a, v4i b) { return { _mm_sub_epi32(a.v, b.v) }; }
+inline v4i operator&(v4i a, v4i b) { return { _mm_and_si128(a.v, b.v) }; }
+inline v4i operator|(v4i a, v4i b) { return { _mm_or_si128(a.v, b.v) }; }
+inline v4i operator^(v4i a, v4i b) { return { _mm_xor_si128(a.v, b.v) }; }
+inline v4i shiftLeft(v4i a, int n) { return { _mm_slli_epi32(a.v, n) }; }
+inline v4i shiftRightLogical(v4i a, int n) { return { _mm_srli_epi32(a.v, n) }; }
+inline v4i shiftRightArithmetic(v4i a, int n) { return { _mm_srai_epi32(a.v, n) }; }
+
+// Reinterpret the bits of a vector as the other type
+inline v4i asInt(v4f a) { return { _mm_castps_si128(a.v) }; }
+inline v4f asFloat(v4i a) { return { _mm_castsi128_ps(a.v) }; }
+inline v4f toFloat(v4i a) { return { _mm_cvtepi32_ps(a.v) }; }
+// Round to nearest, ties to even
+inline v4i toInt(v4f a) { return { _mm_cvtps_epi32(a.v) }; }
+
+// Narrowing stores. Lanes must already be in range of the output type.
+inline void storeInt16(int16_t *p, v4i a)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(a.v, a.v));
+}
+
+inline void storeInt8(int8_t *p, v4i a)
+{
+    __m128i w = _mm_packs_epi32(a.v, a.v);
+    int32_t b = _mm_cvtsi128_si32(_mm_packs_epi16(w, w));
+    memcpy(p, &b, sizeof(b));
+}
+
+inline void storeUint8(uint8_t *p, v4i a)
+{
+    __m128i w = _mm_packs_epi32(a.v, a.v);
+    int32_t b = _mm_cvtsi128_si32(_mm_packus_epi16(w, w));
+    memcpy(p, &b, sizeof(b));
+}
+
+inline v4i loadInt32(const void *p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+
+// Load 4 int16s with each in both halves of its lane, so shifting right by
+// 16 sign extends it, and byte swapping first makes it big-endian
+inline v4i loadInt16Pairs(const void *p)
+{
+    __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return { _mm_unpacklo_epi16(a, a) };
+}
+
+// Load 4 interleaved complex samples as separate real and imaginary parts
+inline void loadComplex(const std::complex<float> *p, v4f &re, v4f &im)
+{
+    auto f = reinterpret_cast<const float*>(p);
+    __m128 a = _mm_loadu_ps(f);
+    __m128 b = _mm_loadu_ps(f + 4);
+    re.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    im.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+inline void storeComplex(std::complex<float> *p, v4f re, v4f im)
+{
+    auto f = reinterpret_cast<float*>(p);
+    _mm_storeu_ps(f, _mm_unpacklo_ps(re.v, im.v));
+    _mm_storeu_ps(f + 4, _mm_unpackhi_ps(re.v, im.v));
+}
+
+#else
+
+struct v4f {
+    float v[4];
+};
+
+inline v4f load(const float *p) { v4f r; memcpy(r.v, p, sizeof(r.v)); return r; }
+inline void store(float *p, v4f a) { memcpy(p, a.v, sizeof(a.v)); }
+inline v4f set1(float f) { return { { f, f, f, f } }; }
+
+#define SIMD_LANEWISE(expr) \
+    v4f r; for (int i = 0; i < 4; i++) { r.v[i] = (expr); } return r;
+
+inline v4f operator+(v4f a, v4f b) { SIMD_LANEWISE(a.v[i] + b.v[i]) }
+inline v4f operator-(v4f a, v4f b) { SIMD_LANEWISE(a.v[i] - b.v[i]) }
+inline v4f operator*(v4f a, v4f b) { SIMD_LANEWISE(a.v[i] * b.v[i]) }
+inline v4f operator/(v4f a, v4f b) { SIMD_LANEWISE(a.v[i] / b.v[i]) }
+inline v4f min(v4f a, v4f b) { SIMD_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]) }
+inline v4f max(v4f a, v4f b) { SIMD_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]) }
+
+inline float laneMask(bool b)
+{
+    uint32_t bits = b ? 0xffffffffu : 0;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline float laneBits(float a, float b, int op)
+{
+    uint32_t x, y;
+    memcpy(&x, &a, sizeof(x));
+    memcpy(&y, &b, sizeof(y));
+    x = (op == 0) ? (x & y) : (op == 1) ? (x | y) : (~x & y);
+    memcpy(&a, &x, sizeof(a));
+    return a;
+}
+
+inline v4f greater(v4f a, v4f b) { SIMD_LANEWISE(laneMask(a.v[i] > b.v[i])) }
+inline v4f less(v4f a, v4f b) { SIMD_LANEWISE(laneMask(a.v[i] < b.v[i])) }
+
+inline v4f bitAnd(v4f a, v4f b) { SIMD_LANEWISE(laneBits(a.v[i], b.v[i], 0)) }
+inline v4f bitOr(v4f a, v4f b) { SIMD_LANEWISE(laneBits(a.v[i], b.v[i], 1)) }
+inline v4f bitAndNot(v4f a, v4f b) { SIMD_LANEWISE(laneBits(a.v[i], b.v[i], 2)) }
+
+#undef SIMD_LANEWISE
+
+struct v4i {
+    int32_t v[4];
+};
+
+#define SIMD_LANEWISE(expr) \
+    v4i r; for (int i = 0; i < 4; i++) { r.v[i] = (expr); } return r;
+
+inline v4i set1i(int32_t i) { return { { i, i, i, i } }; }
+inline v4i seti(int32_t a, int32_t b, int32_t c, int32_t d) { return { { a, b, c, d } }; }
+inline v4i operator+(v4i a, v4i b) { SIMD_LANEWISE(a.v[i] + b.v[i]) }
+inline v4i operator-(v4i a, v4i b) { SIMD_LANEWISE(a.v[i] - b.v[i]) }
+inline v4i operator&(v4i a, v4i b) { SIMD_LANEWISE(a.v[i] & b.v[i]) }
+inline v4i operator|(v4i a, v4i b) { SIMD_LANEWISE(a.v[i] | b.v[i]) }
+inline v4i operator^(v4i a, v4i b) { SIMD_LANEWISE(a.v[i] ^ b.v[i]) }
+inline v4i shiftLeft(v4i a, int n) { SIMD_LANEWISE((int32_t)((uint32_t)a.v[i] << n)) }
+inline v4i shiftRightLogical(v4i a, int n) { SIMD_LANEWISE((int32_t)((uint32_t)a.v[i] >> n)) }
+inline v4i shiftRightArithmetic(v4i a, int n) { SIMD_LANEWISE(a.v[i] >> n) }
+inline v4i toInt(v4f a) { SIMD_LANEWISE((int32_t)lrintf(a.v[i])) }
+
+#undef SIMD_LANEWISE
+
+inline v4i asInt(v4f a) { v4i r; memcpy(r.v, a.v, sizeof(r.v)); return r; }
+inline v4f asFloat(v4i a) { v4f r; memcpy(r.v, a.v, sizeof(r.v)); return r; }
+inline v4f toFloat(v4i a) { return { { (float)a.v[0], (float)a.v[1], (float)a.v[2], (float)a.v[3] } }; }
+
+inline v4i loadInt32(const void *p) { v4i r; memcpy(r.v, p, sizeof(r.v)); return r; }
+
+inline v4i loadInt16Pairs(const void *p)
+{
+    uint16_t h[4];
+    memcpy(h, p, sizeof(h));
+    return { { (int32_t)(h[0] * 0x10001u), (int32_t)(h[1] * 0x10001u), (int32_t)(h[2] * 0x10001u), (int32_t)(h[3] * 0x10001u) } };
+}
+
+inline void storeInt16(int16_t *p, v4i a) { for (int i = 0; i < 4; i++) p[i] = (int16_t)a.v[i]; }
+inline void storeInt8(int8_t *p, v4i a) { for (int i = 0; i < 4; i++) p[i] = (int8_t)a.v[i]; }
+inline void storeUint8(uint8_t *p, v4i a) { for (int i = 0; i < 4; i++) p[i] = (uint8_t)a.v[i]; }
+
+inline void loadComplex(const std::complex<float> *p, v4f &re, v4f &im)
+{
+    for (int i = 0; i < 4; i++) {
+        re.v[i] = p[i].real();
+        im.v[i] = p[i].imag();
+    }
+}
+
+inline void storeComplex(std::complex<float> *p, v4f re, v4f im)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = { re.v[i], im.v[i] };
+    }
+}
+
+#endif
+
+// Lanes of a where mask is set, otherwise lanes of b
+inline v4f select(v4f mask, v4f a, v4f b) { return bitOr(bitAnd(mask, a), bitAndNot(mask, b)); }
+
+inline v4f signMask() { return set1(-0.0f); }
+inline v4f abs(v4f a) { return bitAndNot(signMask(), a); }
+
+}
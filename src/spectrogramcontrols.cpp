@@ -41,6 +41,14 @@ SpectrogramControls::SpectrogramControls(const QString & title, QWidget * parent
     sampleRate->setValidator(double_validator);
     layout->addRow(new QLabel(tr("Sample rate:")), sampleRate);
 
+    followCheckBox = new QCheckBox(widget);
+    layout->addRow(new QLabel(tr("Follow growing file:")), followCheckBox);
+
+    autoScrollCheckBox = new QCheckBox(widget);
+    autoScrollCheckBox->setCheckState(Qt::Checked);
+    autoScrollCheckBox->setEnabled(false);
+    layout->addRow(new QLabel(tr("Scroll to new samples:")), autoScrollCheckBox);
+
     // Spectrogram settings
     layout->addRow(new QLabel()); // TODO: find a better way to add an empty row?
     layout->addRow(new QLabel(tr("<b>Spectrogram</b>")));
@@ -69,6 +77,9 @@ SpectrogramControls::SpectrogramControls(const QString & title, QWidget * parent
     scalesCheckBox->setCheckState(Qt::Checked);
     layout->addRow(new QLabel(tr("Scales:")), scalesCheckBox);
 
+    perfHudCheckBox = new QCheckBox(widget);
+    layout->addRow(new QLabel(tr("Performance overlay:")), perfHudCheckBox);
+
     // Time selection settings
     layout->addRow(new QLabel()); // TODO: find a better way to add an empty row?
     layout->addRow(new QLabel(tr("<b>Time selection</b>")));
@@ -109,6 +120,7 @@ SpectrogramControls::SpectrogramControls(const QString & title, QWidget * parent
     connect(zoomLevelSlider, &QSlider::valueChanged, this, &SpectrogramControls::zoomLevelChanged);
     connect(fileOpenButton, &QPushButton::clicked, this, &SpectrogramControls::fileOpenButtonClicked);
     connect(cursorsCheckBox, &QCheckBox::stateChanged, this, &SpectrogramControls::cursorsStateChanged);
+    connect(followCheckBox, &QCheckBox::toggled, autoScrollCheckBox, &QCheckBox::setEnabled);
     connect(powerMinSlider, &QSlider::valueChanged, this, &SpectrogramControls::powerMinChanged);
     connect(powerMaxSlider, &QSlider::valueChanged, this, &SpectrogramControls::powerMaxChanged);
 }
@@ -63,6 +63,8 @@ private:
 public:
     QPushButton *fileOpenButton;
     QLineEdit *sampleRate;
+    QCheckBox *followCheckBox;
+    QCheckBox *autoScrollCheckBox;
     QSlider *fftSizeSlider;
     QSlider *zoomLevelSlider;
     QSlider *powerMaxSlider;
@@ -74,6 +76,7 @@ public:
     QLabel *symbolRateLabel;
     QLabel *symbolPeriodLabel;
     QCheckBox *scalesCheckBox;
+    QCheckBox *perfHudCheckBox;
     QCheckBox *annosCheckBox;
     QCheckBox *commentsCheckBox;
 };
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spectrogramengine.h"
+#include <algorithm>
+#include <limits>
+#include "kernels.h"
+
+// RGB from HSV with full saturation, as 0xffRRGGBB
+static uint32_t hsvToRgb(float h, float v)
+{
+    float h6 = h * 6;
+    int sector = (int)h6;
+    float f = h6 - sector;
+    float q = v * (1 - f);
+    float t = v * f;
+    float r, g, b;
+    switch (sector % 6) {
+    case 0: r = v; g = t; b = 0; break;
+    case 1: r = q; g = v; b = 0; break;
+    case 2: r = 0; g = v; b = t; break;
+    case 3: r = 0; g = q; b = v; break;
+    case 4: r = t; g = 0; b = v; break;
+    default: r = v; g = 0; b = q; break;
+    }
+    auto byte = [](float c) { return (uint32_t)lrintf(clamp(c, 0.0f, 1.0f) * 255); };
+    return 0xff000000 | (byte(r) << 16) | (byte(g) << 8) | byte(b);
+}
+
+SpectrogramEngine::SpectrogramEngine(std::shared_ptr<SampleSource<std::complex<float>>> src) : inputSource(src)
+{
+    for (int i = 0; i < 256; i++) {
+        float p = (float)i / 256;
+        colormap[i] = hsvToRgb(p * 0.83f, 1.0 - p);
+    }
+    updatePowerRange();
+}
+
+void SpectrogramEngine::setFFTSize(int size)
+{
+    fftSize = size;
+    fft.reset(new FFT(fftSize));
+
+    window.reset(new float[fftSize]);
+    for (int i = 0; i < fftSize; i++) {
+        window[i] = 0.5f * (1.0f - cos(Tau * i / (fftSize - 1)));
+    }
+}
+
+void SpectrogramEngine::setZoomLevel(int zoom)
+{
+    zoomLevel = zoom;
+}
+
+void SpectrogramEngine::setPowerMax(float power)
+{
+    powerMax = power;
+    updatePowerRange();
+}
+
+void SpectrogramEngine::setPowerMin(float power)
+{
+    powerMin = power;
+    updatePowerRange();
+}
+
+void SpectrogramEngine::updatePowerRange()
+{
+    powerRange = -1.0f / std::abs(int(powerMin - powerMax));
+}
+
+int SpectrogramEngine::getStride()
+{
+    return fftSize / zoomLevel;
+}
+
+int SpectrogramEngine::linesPerTile()
+{
+    return tileSize / fftSize;
+}
+
+void SpectrogramEngine::getFFTTile(float *dest, size_t tile)
+{
+    float *ptr = dest;
+    size_t sample = tile;
+    while ((ptr - dest) < tileSize) {
+        getLine(ptr, sample);
+        sample += getStride();
+        ptr += fftSize;
+    }
+}
+
+void SpectrogramEngine::getLine(float *dest, size_t sample)
+{
+    if (inputSource && fft) {
+        // Make sample be the midpoint of the FFT, unless this takes us
+        // past the beginning of the inputSource (if we remove the
+        // std::max(·, 0), then an ugly red bar appears at the beginning
+        // of the spectrogram with large zooms and FFT sizes).
+        const auto first_sample = std::max(static_cast<ssize_t>(sample) - fftSize / 2,
+                        static_cast<ssize_t>(0));
+        auto buffer = inputSource->getSamples(first_sample, fftSize);
+        if (buffer == nullptr) {
+            auto neg_infinity = -1 * std::numeric_limits<float>::infinity();
+            for (int i = 0; i < fftSize; i++, dest++)
+                *dest = neg_infinity;
+            return;
+        }
+
+        for (int i = 0; i < fftSize; i++) {
+            buffer[i] *= window[i];
+        }
+
+        fft->process(buffer.get(), buffer.get());
+        const float invFFTSize = 1.0f / fftSize;
+        // Start from the middle of the FFTW array and wrap
+        // to rearrange the data
+        const int half = fftSize / 2;
+        kernels::powerDb(&buffer[half], dest, half, invFFTSize * invFFTSize);
+        kernels::powerDb(&buffer[0], dest + half, half, invFFTSize * invFFTSize);
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <complex>
+#include <memory>
+#include <stdint.h>
+#include "fft.h"
+#include "samplesource.h"
+#include "util.h"
+
+/*
+ * The spectrogram maths behind SpectrogramPlot, without any widgets, so
+ * it can also be used headless.
+ *
+ * A tile is linesPerTile() FFT lines, each getStride() samples apart and
+ * fftSize bins long, with the negative frequencies first. Each engine has
+ * its own FFT buffers, so use one engine per thread.
+ */
+class SpectrogramEngine
+{
+public:
+    static const int tileSize = 65536; // This must be a multiple of the maximum FFT size
+
+    SpectrogramEngine(std::shared_ptr<SampleSource<std::complex<float>>> src);
+    void setFFTSize(int size);
+    void setZoomLevel(int zoom);
+    void setPowerMax(float power);
+    void setPowerMin(float power);
+    int getFFTSize() { return fftSize; };
+    int getStride();
+    int linesPerTile();
+
+    // Power in dB of the FFT centred on sample
+    void getLine(float *dest, size_t sample);
+    // Fills dest with tileSize values for the tile starting at sample tile
+    void getFFTTile(float *dest, size_t tile);
+
+    // Colour (as 0xAARRGGBB) of a power in dB, from powerMax down to powerMin
+    uint32_t colour(float power) {
+        float normPower = clamp((power - powerMax) * powerRange, 0.0f, 1.0f);
+        return colormap[(uint8_t)(normPower * (256 - 1))];
+    };
+
+private:
+    std::shared_ptr<SampleSource<std::complex<float>>> inputSource;
+    std::unique_ptr<FFT> fft;
+    std::unique_ptr<float[]> window;
+    uint32_t colormap[256];
+
+    int fftSize = 0;
+    int zoomLevel = 1;
+    float powerMax = 0.0f;
+    float powerMin = -50.0f;
+    float powerRange;
+
+    void updatePowerRange();
+};
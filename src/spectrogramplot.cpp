@@ -23,17 +23,18 @@
 #include <QElapsedTimer>
 #include <QPainter>
 #include <QPaintEvent>
-#include <QPixmapCache>
 #include <QRect>
 #include <liquid/liquid.h>
 #include <algorithm>
 #include <functional>
 #include <cstdlib>
 #include <limits>
+#include "perfstats.h"
+#include "tracing.h"
 #include "util.h"
 
 
-SpectrogramPlot::SpectrogramPlot(std::shared_ptr<SampleSource<std::complex<float>>> src) : Plot(src), inputSource(src), fftSize(512), tuner(fftSize, this)
+SpectrogramPlot::SpectrogramPlot(std::shared_ptr<SampleSource<std::complex<float>>> src) : Plot(src), inputSource(src), engine(src), fftSize(512), tuner(fftSize, this)
 {
     setFFTSize(fftSize);
     zoomLevel = 1;
@@ -43,22 +44,45 @@ SpectrogramPlot::SpectrogramPlot(std::shared_ptr<SampleSource<std::complex<float
     frequencyScaleEnabled = false;
     sigmfAnnotationsEnabled = true;
 
-    for (int i = 0; i < 256; i++) {
-        float p = (float)i / 256;
-        colormap[i] = QColor::fromHsvF(p * 0.83f, 1.0, 1.0 - p).rgba();
-    }
-
     tunerTransform = std::make_shared<TunerTransform>(src);
     connect(&tuner, &Tuner::tunerMoved, this, &SpectrogramPlot::tunerMoved);
 }
 
-void SpectrogramPlot::invalidateEvent()
+// Whether a tile uses any of the samples an invalidation affects
+static bool tileAffected(const TileCacheKey &key, const Invalidation &invalidation)
 {
-    // HACK: this makes sure we update the height for real signals (as InputSource is passed here before the file is opened)
-    setFFTSize(fftSize);
+    const size_t stride = key.fftSize / key.zoomLevel;
+    const size_t lines = SpectrogramEngine::tileSize / key.fftSize;
+    const size_t half = key.fftSize / 2;
+    const size_t start = key.sample > half ? key.sample - half : 0;
+    const size_t end = key.sample + (lines - 1) * stride + half;
+    return invalidation.affects(start, end);
+}
 
-    pixmapCache.clear();
-    fftCache.clear();
+void SpectrogramPlot::invalidateEvent(const Invalidation &invalidation)
+{
+    // The sample rate only changes the scales
+    if (!invalidation.changesSamples()) {
+        emit repaint();
+        return;
+    }
+
+    if (invalidation.type == Invalidation::Samples) {
+        for (auto &key : fftCache.keys()) {
+            if (tileAffected(key, invalidation))
+                fftCache.remove(key);
+        }
+        for (auto &key : pixmapCache.keys()) {
+            if (tileAffected(key, invalidation))
+                pixmapCache.remove(key);
+        }
+    } else {
+        // HACK: this makes sure we update the height for real signals (as InputSource is passed here before the file is opened)
+        setFFTSize(fftSize);
+
+        pixmapCache.clear();
+        fftCache.clear();
+    }
     emit repaint();
 }
 
@@ -190,7 +214,7 @@ void SpectrogramPlot::paintAnnotations(QPainter &painter, QRect &rect, range_t<s
 
         if(start <= sampleRange.maximum && end >= sampleRange.minimum) {
 
-            double frequency = a.frequencyRange.maximum - inputSource->getFrequency();
+            double frequency = a.frequencyRange.maximum - inputSource->captureFrequency(a.sampleRange.minimum);
             int x = (a.sampleRange.minimum - sampleRange.minimum) / getStride();
             int y = zero - frequency / sampleRate * rect.height();
             int height = (a.frequencyRange.maximum - a.frequencyRange.minimum) / sampleRate * rect.height();
@@ -245,21 +269,20 @@ void SpectrogramPlot::paintMid(QPainter &painter, QRect &rect, range_t<size_t> s
 QPixmap* SpectrogramPlot::getPixmapTile(size_t tile)
 {
     QPixmap *obj = pixmapCache.object(TileCacheKey(fftSize, zoomLevel, tile));
+    PerfStats::pixmapCache.lookup(obj != 0);
     if (obj != 0)
         return obj;
 
+    TraceScope trace("SpectrogramPlot::getPixmapTile");
+
     float *fftTile = getFFTTile(tile);
     obj = new QPixmap(linesPerTile(), fftSize);
     QImage image(linesPerTile(), fftSize, QImage::Format_RGB32);
-    float powerRange = -1.0f / std::abs(int(powerMin - powerMax));
     for (int y = 0; y < fftSize; y++) {
         auto scanLine = (QRgb*)image.scanLine(fftSize - y - 1);
         for (int x = 0; x < linesPerTile(); x++) {
             float *fftLine = &fftTile[x * fftSize];
-            float normPower = (fftLine[y] - powerMax) * powerRange;
-            normPower = clamp(normPower, 0.0f, 1.0f);
-
-            scanLine[x] = colormap[(uint8_t)(normPower * (256 - 1))];
+            scanLine[x] = engine.colour(fftLine[y]);
         }
     }
     obj->convertFromImage(image);
@@ -270,61 +293,21 @@ QPixmap* SpectrogramPlot::getPixmapTile(size_t tile)
 float* SpectrogramPlot::getFFTTile(size_t tile)
 {
     std::array<float, tileSize>* obj = fftCache.object(TileCacheKey(fftSize, zoomLevel, tile));
+    PerfStats::fftCache.lookup(obj != nullptr);
     if (obj != nullptr)
         return obj->data();
 
+    TraceScope trace("SpectrogramPlot::getFFTTile");
+
     std::array<float, tileSize>* destStorage = new std::array<float, tileSize>;
-    float *ptr = destStorage->data();
-    size_t sample = tile;
-    while ((ptr - destStorage->data()) < tileSize) {
-        getLine(ptr, sample);
-        sample += getStride();
-        ptr += fftSize;
-    }
+    engine.getFFTTile(destStorage->data(), tile);
     fftCache.insert(TileCacheKey(fftSize, zoomLevel, tile), destStorage);
     return destStorage->data();
 }
 
-void SpectrogramPlot::getLine(float *dest, size_t sample)
-{
-    if (inputSource && fft) {
-        // Make sample be the midpoint of the FFT, unless this takes us
-        // past the beginning of the inputSource (if we remove the
-        // std::max(·, 0), then an ugly red bar appears at the beginning
-        // of the spectrogram with large zooms and FFT sizes).
-        const auto first_sample = std::max(static_cast<ssize_t>(sample) - fftSize / 2,
-                        static_cast<ssize_t>(0));
-        auto buffer = inputSource->getSamples(first_sample, fftSize);
-        if (buffer == nullptr) {
-            auto neg_infinity = -1 * std::numeric_limits<float>::infinity();
-            for (int i = 0; i < fftSize; i++, dest++)
-                *dest = neg_infinity;
-            return;
-        }
-
-        for (int i = 0; i < fftSize; i++) {
-            buffer[i] *= window[i];
-        }
-
-        fft->process(buffer.get(), buffer.get());
-        const float invFFTSize = 1.0f / fftSize;
-        const float logMultiplier = 10.0f / log2f(10.0f);
-        for (int i = 0; i < fftSize; i++) {
-            // Start from the middle of the FFTW array and wrap
-            // to rearrange the data
-            int k = i ^ (fftSize >> 1);
-            auto s = buffer[k] * invFFTSize;
-            float power = s.real() * s.real() + s.imag() * s.imag();
-            float logPower = log2f(power) * logMultiplier;
-            *dest = logPower;
-            dest++;
-        }
-    }
-}
-
 int SpectrogramPlot::getStride()
 {
-    return fftSize / zoomLevel;
+    return engine.getStride();
 }
 
 float SpectrogramPlot::getTunerPhaseInc()
@@ -348,7 +331,7 @@ std::vector<float> SpectrogramPlot::getTunerTaps()
 
 int SpectrogramPlot::linesPerTile()
 {
-    return tileSize / fftSize;
+    return engine.linesPerTile();
 }
 
 bool SpectrogramPlot::mouseEvent(QEvent::Type type, QMouseEvent *event)
@@ -374,12 +357,7 @@ void SpectrogramPlot::setFFTSize(int size)
 {
     float sizeScale = float(size) / float(fftSize);
     fftSize = size;
-    fft.reset(new FFT(fftSize));
-
-    window.reset(new float[fftSize]);
-    for (int i = 0; i < fftSize; i++) {
-        window[i] = 0.5f * (1.0f - cos(Tau * i / (fftSize - 1)));
-    }
+    engine.setFFTSize(fftSize);
 
     if (inputSource->realSignal()) {
         setHeight(fftSize/2);
@@ -396,6 +374,7 @@ void SpectrogramPlot::setFFTSize(int size)
 void SpectrogramPlot::setPowerMax(int power)
 {
     powerMax = power;
+    engine.setPowerMax(power);
     pixmapCache.clear();
     tunerMoved();
 }
@@ -403,12 +382,14 @@ void SpectrogramPlot::setPowerMax(int power)
 void SpectrogramPlot::setPowerMin(int power)
 {
     powerMin = power;
+    engine.setPowerMin(power);
     pixmapCache.clear();
 }
 
 void SpectrogramPlot::setZoomLevel(int zoom)
 {
     zoomLevel = zoom;
+    engine.setZoomLevel(zoom);
 }
 
 void SpectrogramPlot::setSampleRate(double rate)
@@ -438,12 +419,7 @@ bool SpectrogramPlot::tunerEnabled()
 
 void SpectrogramPlot::tunerMoved()
 {
-    tunerTransform->setFrequency(getTunerPhaseInc());
-    tunerTransform->setTaps(getTunerTaps());
-    tunerTransform->setRelativeBandwith(tuner.deviation() * 2.0 / height());
-
-    // TODO: for invalidating traceplot cache, this shouldn't really go here
-    QPixmapCache::clear();
+    tunerTransform->setTuning(getTunerPhaseInc(), getTunerTaps(), tuner.deviation() * 2.0 / height());
 
     emit repaint();
 }
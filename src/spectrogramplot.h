@@ -22,9 +22,9 @@
 #include <QCache>
 #include <QString>
 #include <QWidget>
-#include "fft.h"
 #include "inputsource.h"
 #include "plot.h"
+#include "spectrogramengine.h"
 #include "tuner.h"
 #include "tunertransform.h"
 
@@ -63,7 +63,7 @@ class SpectrogramPlot : public Plot
 
 public:
     SpectrogramPlot(std::shared_ptr<SampleSource<std::complex<float>>> src);
-    void invalidateEvent() override;
+    void invalidateEvent(const Invalidation &invalidation) override;
     std::shared_ptr<AbstractSampleSource> output() override;
     void paintFront(QPainter &painter, QRect &rect, range_t<size_t> sampleRange) override;
     void paintMid(QPainter &painter, QRect &rect, range_t<size_t> sampleRange) override;
@@ -72,10 +72,13 @@ public:
     std::shared_ptr<SampleSource<std::complex<float>>> input() { return inputSource; };
     void setSampleRate(double sampleRate);
     bool tunerEnabled();
+    int tunerCentre() { return tuner.centre(); };
     void enableScales(bool enabled);
     void enableAnnotations(bool enabled);
     bool isAnnotationsEnabled();
     QString *mouseAnnotationComment(const QMouseEvent *event);
+    QPixmap* getPixmapTile(size_t tile);
+    float* getFFTTile(size_t tile);
 
 public slots:
     void setFFTSize(int size);
@@ -86,15 +89,13 @@ public slots:
 
 private:
     const int linesPerGraduation = 50;
-    static const int tileSize = 65536; // This must be a multiple of the maximum FFT size
+    static const int tileSize = SpectrogramEngine::tileSize;
 
     std::shared_ptr<SampleSource<std::complex<float>>> inputSource;
     std::vector<AnnotationLocation> visibleAnnotationLocations;
-    std::unique_ptr<FFT> fft;
-    std::unique_ptr<float[]> window;
+    SpectrogramEngine engine;
     QCache<TileCacheKey, QPixmap> pixmapCache;
     QCache<TileCacheKey, std::array<float, tileSize>> fftCache;
-    uint colormap[256];
 
     int fftSize;
     int zoomLevel;
@@ -107,9 +108,6 @@ private:
     Tuner tuner;
     std::shared_ptr<TunerTransform> tunerTransform;
 
-    QPixmap* getPixmapTile(size_t tile);
-    float* getFFTTile(size_t tile);
-    void getLine(float *dest, size_t sample);
     int getStride();
     float getTunerPhaseInc();
     std::vector<float> getTunerTaps();
@@ -19,9 +19,39 @@
 
 #pragma once
 
+#include <stdint.h>
+#include "util.h"
+
+// What changed about a sample source, so subscribers only throw away
+// what is no longer valid
+struct Invalidation
+{
+    enum Type {
+        // Only metadata (e.g. the sample rate) changed, not the samples
+        Metadata,
+        // The samples in range changed or were added
+        Samples,
+        // A parameter of the source changed, so any sample may have too
+        Parameters,
+    };
+
+    Type type;
+    // Samples [minimum, maximum) affected, for Samples
+    range_t<size_t> range;
+
+    static Invalidation metadata() { return {Metadata, {0, 0}}; };
+    static Invalidation samples(size_t start, size_t end) { return {Samples, {start, end}}; };
+    static Invalidation parameters() { return {Parameters, {0, SIZE_MAX}}; };
+
+    bool changesSamples() const { return type != Metadata; };
+    // Whether any of the samples [start, end) changed
+    bool affects(size_t start, size_t end) const {
+        return type == Parameters || (type == Samples && start < range.maximum && range.minimum < end);
+    };
+};
 
 class Subscriber
 {
 public:
-    virtual void invalidateEvent() = 0;
+    virtual void invalidateEvent(const Invalidation &invalidation) = 0;
 };
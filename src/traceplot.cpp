@@ -21,13 +21,32 @@
 #include <QTextStream>
 #include <QtConcurrent>
 #include <QPainterPath>
+#include "perfstats.h"
 #include "samplesource.h"
 #include "traceplot.h"
+#include "tracing.h"
 
 TracePlot::TracePlot(std::shared_ptr<AbstractSampleSource> source) : Plot(source) {
     connect(this, &TracePlot::imageReady, this, &TracePlot::handleImage);
 }
 
+void TracePlot::invalidateEvent(const Invalidation &invalidation)
+{
+    if (!invalidation.changesSamples())
+        return;
+
+    // Tiles still being drawn are dropped when they arrive
+    for (auto it = tileRanges.begin(); it != tileRanges.end();) {
+        if (invalidation.affects(it.value().minimum, it.value().maximum)) {
+            QPixmapCache::remove(it.key());
+            it = tileRanges.erase(it);
+        } else {
+            it++;
+        }
+    }
+    emit repaint();
+}
+
 void TracePlot::paintMid(QPainter &painter, QRect &rect, range_t<size_t> sampleRange)
 {
     if (sampleRange.length() == 0) return;
@@ -59,10 +78,13 @@ QPixmap TracePlot::getTile(size_t tileID, size_t sampleCount)
     QPixmap pixmap(tileWidth, height());
     QString key;
     QTextStream(&key) << "traceplot_" << this << "_" << tileID << "_" << sampleCount;
-    if (QPixmapCache::find(key, &pixmap))
+    bool cached = QPixmapCache::find(key, &pixmap);
+    PerfStats::traceCache.lookup(cached);
+    if (cached)
         return pixmap;
 
     if (!tasks.contains(key)) {
+        PerfStats::tilesPending++;
         range_t<size_t> sampleRange{tileID * sampleCount, (tileID + 1) * sampleCount};
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         QtConcurrent::run(&TracePlot::drawTile, this, key, QRect(0, 0, tileWidth, height()), sampleRange);
@@ -70,6 +92,7 @@ QPixmap TracePlot::getTile(size_t tileID, size_t sampleCount)
         QtConcurrent::run(this, &TracePlot::drawTile, key, QRect(0, 0, tileWidth, height()), sampleRange);
 #endif
         tasks.insert(key);
+        tileRanges[key] = sampleRange;
     }
     pixmap.fill(Qt::transparent);
     return pixmap;
@@ -77,6 +100,8 @@ QPixmap TracePlot::getTile(size_t tileID, size_t sampleCount)
 
 void TracePlot::drawTile(QString key, const QRect &rect, range_t<size_t> sampleRange)
 {
+    PerfStats::WorkerTask task;
+    TraceScope trace("TracePlot::drawTile");
     QImage image(rect.size(), QImage::Format_ARGB32);
     image.fill(Qt::transparent);
 
@@ -114,13 +139,24 @@ void TracePlot::drawTile(QString key, const QRect &rect, range_t<size_t> sampleR
 
 void TracePlot::handleImage(QString key, QImage image)
 {
-    auto pixmap = QPixmap::fromImage(image);
-    QPixmapCache::insert(key, pixmap);
     tasks.remove(key);
+    if (tileRanges.contains(key))
+        QPixmapCache::insert(key, QPixmap::fromImage(image));
+
+    // Forget tiles that have been evicted, so this doesn't grow forever
+    if (tileRanges.size() > maxTileRanges) {
+        QPixmap pixmap;
+        for (auto it = tileRanges.begin(); it != tileRanges.end();) {
+            if (!tasks.contains(it.key()) && !QPixmapCache::find(it.key(), &pixmap))
+                it = tileRanges.erase(it);
+            else
+                it++;
+        }
+    }
     emit repaint();
 }
 
-void TracePlot::plotTrace(QPainter &painter, const QRect &rect, float *samples, size_t count, int step = 1)
+void TracePlot::plotTrace(QPainter &painter, const QRect &rect, float *samples, size_t count, int step)
 {
     QPainterPath path;
     range_t<float> xRange{0, rect.width() - 2.f};
@@ -18,6 +18,8 @@
  */
 
 #pragma once
+#include <QHash>
+#include <QSet>
 #include <memory>
 #include "abstractsamplesource.h"
 #include "plot.h"
@@ -29,9 +31,11 @@ class TracePlot : public Plot
 
 public:
     TracePlot(std::shared_ptr<AbstractSampleSource> source);
+    void invalidateEvent(const Invalidation &invalidation) override;
 
     void paintMid(QPainter &painter, QRect &rect, range_t<size_t> sampleRange);
     std::shared_ptr<AbstractSampleSource> source() { return sampleSource; };
+    static void plotTrace(QPainter &painter, const QRect &rect, float *samples, size_t count, int step = 1);
 
 signals:
     void imageReady(QString key, QImage image);
@@ -41,9 +45,11 @@ public slots:
 
 private:
     QSet<QString> tasks;
+    // Samples drawn in each tile that is cached or being drawn, by key
+    QHash<QString, range_t<size_t>> tileRanges;
     const int tileWidth = 1000;
+    static const int maxTileRanges = 4096;
 
     QPixmap getTile(size_t tileID, size_t sampleCount);
     void drawTile(QString key, const QRect &rect, range_t<size_t> sampleRange);
-    void plotTrace(QPainter &painter, const QRect &rect, float *samples, size_t count, int step);
 };
@@ -0,0 +1,193 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdio.h>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <stdlib.h>
+#endif
+
+namespace
+{
+
+struct Event {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// Events kept per thread. Once full, the oldest are overwritten, so a long
+// session keeps its most recent activity in bounded memory.
+const size_t maxThreadEvents = 1 << 16;
+
+// One thread's events, so recording doesn't contend on a global lock
+struct ThreadEvents {
+    // Small, stable id, which is easier to read than a native one
+    int id;
+    // Only contended while the trace is written out
+    std::mutex mutex;
+    std::vector<Event> ring;
+    // Events recorded, including any overwritten
+    size_t recorded = 0;
+};
+
+std::mutex mutex;
+std::string traceFilename;
+uint64_t traceStart;
+std::vector<std::shared_ptr<ThreadEvents>> threadEvents;
+std::map<int, std::string> threadNames;
+std::set<std::string> names;
+std::atomic<int> nextThread{1};
+
+ThreadEvents &currentThreadEvents()
+{
+    thread_local std::shared_ptr<ThreadEvents> events;
+    if (events == nullptr) {
+        events = std::make_shared<ThreadEvents>();
+        events->id = nextThread++;
+        auto app = QCoreApplication::instance();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (app != nullptr && QThread::currentThread() == app->thread())
+            threadNames[events->id] = "main";
+        else
+            threadNames[events->id] = "worker " + std::to_string(events->id);
+        threadEvents.push_back(events);
+    }
+    return *events;
+}
+
+}
+
+std::atomic<bool> Trace::active{false};
+
+void Trace::start(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    traceFilename = filename;
+    traceStart = now();
+    for (auto &events : threadEvents) {
+        std::lock_guard<std::mutex> threadLock(events->mutex);
+        events->ring.clear();
+        events->recorded = 0;
+    }
+    active = true;
+}
+
+void Trace::startFromEnvironment()
+{
+    auto filename = qgetenv("INSPECTRUM_TRACE");
+    if (!filename.isEmpty())
+        start(filename.toStdString());
+}
+
+void Trace::finish()
+{
+    if (!active.exchange(false))
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream os(traceFilename);
+    if (!os) {
+        fprintf(stderr, "ERROR: could not write trace to %s\n", traceFilename.c_str());
+        return;
+    }
+
+    // Thread names, then complete ("X") events in microseconds from the
+    // start of the trace
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    const char *separator = "\n";
+    for (auto &thread : threadNames) {
+        os << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first
+           << ",\"args\":{\"name\":\"" << thread.second << "\"}}";
+        separator = ",\n";
+    }
+    os.precision(3);
+    os << std::fixed;
+    size_t dropped = 0;
+    for (auto &events : threadEvents) {
+        std::lock_guard<std::mutex> threadLock(events->mutex);
+        // Oldest first, starting after the newest if the ring wrapped
+        const size_t count = events->ring.size();
+        for (size_t i = 0; i < count; i++) {
+            auto &event = events->ring[(events->recorded + i) % count];
+            os << separator << "{\"name\":\"" << event.name << "\",\"cat\":\"inspectrum\",\"ph\":\"X\",\"pid\":1"
+               << ",\"tid\":" << events->id
+               << ",\"ts\":" << (event.start - traceStart) / 1e3
+               << ",\"dur\":" << (event.end - event.start) / 1e3 << "}";
+            separator = ",\n";
+        }
+        dropped += events->recorded - count;
+        events->ring.clear();
+        events->recorded = 0;
+    }
+    os << "\n]}\n";
+    if (dropped > 0)
+        fprintf(stderr, "Trace dropped the %zu oldest events\n", dropped);
+}
+
+uint64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char *name, uint64_t start, uint64_t end)
+{
+    auto &events = currentThreadEvents();
+    std::lock_guard<std::mutex> lock(events.mutex);
+    if (!active)
+        return;
+    if (events.ring.size() < maxThreadEvents)
+        events.ring.push_back({name, start, end});
+    else
+        events.ring[events.recorded % maxThreadEvents] = {name, start, end};
+    events.recorded++;
+}
+
+const char *Trace::intern(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return names.insert(name).first->c_str();
+}
+
+std::string Trace::typeName(const std::type_info &type)
+{
+#ifdef __GNUG__
+    int status;
+    std::unique_ptr<char, void(*)(void*)> demangled(
+        abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), free);
+    if (status == 0)
+        return demangled.get();
+#endif
+    std::string name = type.name();
+    // MSVC names are "class Foo"
+    auto space = name.rfind(' ');
+    return space == std::string::npos ? name : name.substr(space + 1);
+}
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (C) 2026, Mike Walters <mike@flomp.net>
+ *
+ *  This file is part of inspectrum.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <typeinfo>
+
+/*
+ * Records when jobs (tiles, transforms, reads, paints) ran and on which
+ * thread, and writes them out as a Chrome trace, which can be opened in
+ * chrome://tracing or ui.perfetto.dev. Nothing is recorded unless tracing
+ * was started, and a TraceScope then only costs a relaxed load. Each thread
+ * keeps its own buffer of its most recent events, so long sessions don't
+ * grow without bound.
+ */
+class Trace
+{
+public:
+    // Start recording, to be written to filename by finish()
+    static void start(const std::string &filename);
+    // Start recording if the INSPECTRUM_TRACE environment variable is set
+    // to a filename
+    static void startFromEnvironment();
+    // Write the trace, if recording, and stop
+    static void finish();
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    };
+    static uint64_t now();
+    static void record(const char *name, uint64_t start, uint64_t end);
+
+    // Copy of name that lives as long as the program, for use as an event
+    // name
+    static const char *intern(const std::string &name);
+    // Readable name of a type
+    static std::string typeName(const std::type_info &type);
+
+private:
+    static std::atomic<bool> active;
+};
+
+// Records an event lasting as long as the object. A null name records
+// nothing.
+class TraceScope
+{
+public:
+    TraceScope(const char *name) : name(Trace::enabled() ? name : nullptr) {
+        if (this->name != nullptr)
+            start = Trace::now();
+    };
+    ~TraceScope() {
+        if (name != nullptr)
+            Trace::record(name, start, Trace::now());
+    };
+
+private:
+    const char *name;
+    uint64_t start = 0;
+};
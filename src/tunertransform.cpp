@@ -18,55 +18,130 @@
  */
 
 #include "tunertransform.h"
-#include <liquid/liquid.h>
+#include <QMutexLocker>
 #include "util.h"
 
 TunerTransform::TunerTransform(std::shared_ptr<SampleSource<std::complex<float>>> src) : SampleBuffer(src), frequency(0), bandwidth(1.), taps{1.0f}
 {
+    mix = nco_crcf_create(LIQUID_NCO);
+    filter = firfilt_crcf_create(taps.data(), taps.size());
+    current = filter;
+}
 
+TunerTransform::~TunerTransform()
+{
+    nco_crcf_destroy(mix);
+    firfilt_crcf_destroy(filter);
 }
 
 void TunerTransform::work(void *input, void *output, int count, size_t sampleid)
 {
     auto out = static_cast<std::complex<float>*>(output);
-    auto temp = std::make_unique<std::complex<float>[]>(count);
 
-    // Mix down
-    nco_crcf mix = nco_crcf_create(LIQUID_NCO);
-    nco_crcf_set_phase(mix, fmodf(frequency * sampleid, Tau));
-    nco_crcf_set_frequency(mix, frequency);
+    // Mix down. The phase only depends on the sample index, so set it
+    // every time rather than carrying it over.
+    nco_crcf_set_phase(mix, fmod((double)frequency * sampleid, Tau));
     nco_crcf_mix_block_down(mix,
                             static_cast<std::complex<float>*>(input),
-                            temp.get(),
+                            out,
                             count);
-    nco_crcf_destroy(mix);
 
-    // Filter
-    firfilt_crcf filter = firfilt_crcf_create(taps.data(), taps.size());
+    // Filter in place, carrying on from the previous call's state
     for (int i = 0; i < count; i++)
     {
-        firfilt_crcf_push(filter, temp[i]);
-        firfilt_crcf_execute(filter, &out[i]);
+        firfilt_crcf_push(current, out[i]);
+        firfilt_crcf_execute(current, &out[i]);
     }
+}
+
+TunerTransform::FilterState::FilterState(std::vector<float> &taps)
+{
+    filter = firfilt_crcf_create(taps.data(), taps.size());
+}
+
+TunerTransform::FilterState::~FilterState()
+{
     firfilt_crcf_destroy(filter);
 }
 
-void TunerTransform::setFrequency(float frequency)
+std::unique_ptr<AbstractSampleBuffer::State> TunerTransform::createState()
+{
+    return std::make_unique<FilterState>(taps);
+}
+
+void TunerTransform::useState(State *state)
+{
+    current = state != nullptr ? static_cast<FilterState*>(state)->filter : filter;
+}
+
+size_t TunerTransform::historyLength()
+{
+    // The NCO phase comes from the sample index, so only the filter needs
+    // warming up
+    return taps.size() - 1;
+}
+
+void TunerTransform::applyFrequency(float frequency)
 {
     this->frequency = frequency;
+    nco_crcf_set_frequency(mix, frequency);
 }
 
-void TunerTransform::setTaps(std::vector<float> taps)
+void TunerTransform::applyTaps(std::vector<float> &taps)
 {
     this->taps = taps;
+    firfilt_crcf_destroy(filter);
+    filter = firfilt_crcf_create(this->taps.data(), this->taps.size());
+    current = filter;
+}
+
+void TunerTransform::setFrequency(float frequency)
+{
+    QMutexLocker ml(&mutex);
+    applyFrequency(frequency);
+    resetStreams();
+    ml.unlock();
+    invalidate();
+}
+
+void TunerTransform::setTaps(std::vector<float> taps)
+{
+    QMutexLocker ml(&mutex);
+    applyTaps(taps);
+    resetStreams();
+    ml.unlock();
+    invalidate();
+}
+
+void TunerTransform::setTuning(float frequency, std::vector<float> taps, float bandwidth)
+{
+    QMutexLocker ml(&mutex);
+    applyFrequency(frequency);
+    applyTaps(taps);
+    this->bandwidth = bandwidth;
+    resetStreams();
+    ml.unlock();
+    invalidate();
+}
+
+double TunerTransform::getFrequency()
+{
+    // Mixing down by frequency moves that offset to DC
+    return SampleBuffer::getFrequency() + frequency / Tau * rate();
 }
 
 float TunerTransform::relativeBandwidth() {
+    QMutexLocker ml(&mutex);
     return bandwidth;
 }
 
 void TunerTransform::setRelativeBandwith(float bandwidth)
 {
+    QMutexLocker ml(&mutex);
     this->bandwidth = bandwidth;
+    ml.unlock();
+    // The tuner's own output doesn't change, but downstream stages scale
+    // by the bandwidth, e.g. FrequencyDemod's gain
+    invalidate();
 }
 
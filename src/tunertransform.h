@@ -20,6 +20,7 @@
 #pragma once
 
 #include "samplebuffer.h"
+#include <liquid/liquid.h>
 #include <vector>
 
 class TunerTransform : public SampleBuffer<std::complex<float>, std::complex<float>>
@@ -28,12 +29,37 @@ private:
     float frequency;
     float bandwidth;
     std::vector<float> taps;
+    nco_crcf mix;
+    // The filter used by direct work() calls, and the one work() uses now
+    firfilt_crcf filter;
+    firfilt_crcf current;
+
+    struct FilterState : State
+    {
+        FilterState(std::vector<float> &taps);
+        ~FilterState();
+        firfilt_crcf filter;
+    };
+
+    // Called with mutex held
+    void applyFrequency(float frequency);
+    void applyTaps(std::vector<float> &taps);
+
+protected:
+    std::unique_ptr<State> createState() override;
+    void useState(State *state) override;
+    size_t historyLength() override;
 
 public:
     TunerTransform(std::shared_ptr<SampleSource<std::complex<float>>> src);
+    ~TunerTransform();
     void work(void *input, void *output, int count, size_t sampleid) override;
     void setFrequency(float frequency);
     void setTaps(std::vector<float> taps);
     void setRelativeBandwith(float bandwidth);
+    // All three of the above, with a single invalidation
+    void setTuning(float frequency, std::vector<float> taps, float bandwidth);
     float relativeBandwidth() override;
+    bool bandLimited() override { return true; };
+    double getFrequency() override;
 };